@@ -0,0 +1,70 @@
+//Project includes
+#include "AssetLoader.h"
+#include "DataTypes.h"
+#include "MeshCache.h"
+#include "Profiler.h"
+#include "Texture.h"
+
+using namespace dae;
+
+AssetLoader::AssetLoader(int threadCount)
+{
+	if (threadCount <= 0)
+		threadCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+	for (int i{}; i < threadCount; ++i)
+		m_Threads.emplace_back(&AssetLoader::WorkLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_IsRunning = false;
+	}
+	m_Condition.notify_all();
+
+	for (std::thread& thread : m_Threads)
+		thread.join();
+}
+
+std::shared_future<std::shared_ptr<const Texture>> AssetLoader::LoadTexture(const std::string& path)
+{
+	return Enqueue([path]() { return std::shared_ptr<const Texture>{ Texture::LoadFromFile(path) }; });
+}
+
+std::shared_future<std::shared_ptr<const MeshData>> AssetLoader::LoadMesh(const std::string& objPath)
+{
+	//Parsing and the tangents happen in here as well when there is no mesh cache yet
+	return Enqueue([objPath]() { return MeshCache::LoadMesh(objPath); });
+}
+
+void AssetLoader::Push(std::function<void()>&& job)
+{
+	{
+		const std::lock_guard lock{ m_Mutex };
+		m_Jobs.push_back(std::move(job));
+	}
+	m_Condition.notify_one();
+}
+
+void AssetLoader::WorkLoop()
+{
+	PROFILE_THREAD_NAME("AssetLoader");
+	while (true)
+	{
+		std::function<void()> job{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this]() { return !m_Jobs.empty() || !m_IsRunning; });
+			if (m_Jobs.empty())
+				return;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		PROFILE_ZONE("LoadAsset");
+		job();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+//Standard includes
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dae
+{
+	class Texture;
+	struct MeshData;
+
+	//Pool of worker threads running load jobs, every job hands its result back through a shared_future.
+	//Jobs that are queued when the loader is destroyed still run, so no future is left without a value.
+	class AssetLoader final
+	{
+	public:
+		//0 threads uses one per hardware thread
+		explicit AssetLoader(int threadCount = 0);
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) noexcept = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader& operator=(AssetLoader&&) noexcept = delete;
+
+		template<typename Job>
+		std::shared_future<std::invoke_result_t<Job>> Enqueue(Job job)
+		{
+			using Result = std::invoke_result_t<Job>;
+			const auto pTask{ std::make_shared<std::packaged_task<Result()>>(std::move(job)) };
+			std::shared_future<Result> result{ pTask->get_future().share() };
+			Push([pTask]() { (*pTask)(); });
+			return result;
+		}
+
+		//nullptr results when the file could not be loaded
+		std::shared_future<std::shared_ptr<const Texture>> LoadTexture(const std::string& path);
+		std::shared_future<std::shared_ptr<const MeshData>> LoadMesh(const std::string& objPath);
+
+	private:
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::deque<std::function<void()>> m_Jobs{};
+		bool m_IsRunning{ true };
+		std::vector<std::thread> m_Threads{};
+
+		void Push(std::function<void()>&& job);
+		void WorkLoop();
+	};
+}
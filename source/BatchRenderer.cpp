@@ -0,0 +1,222 @@
+//External includes
+#include "SDL.h"
+
+//Standard includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+//Project includes
+#include "BatchRenderer.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+using namespace dae;
+
+namespace
+{
+	void WriteLittleEndian(uint8_t*& pOut, uint32_t value, int byteCount)
+	{
+		for (int i{}; i < byteCount; ++i)
+			*pOut++ = static_cast<uint8_t>(value >> (i * 8));
+	}
+
+	//32 bit top-down BMP, rows can then be appended in render order. XRGB8888 is already the BGRX byte order BMP wants.
+	bool WriteBMPHeader(std::ofstream& file, int width, int height)
+	{
+		constexpr uint32_t headerSize{ 14 + 40 };
+		const uint32_t imageSize{ static_cast<uint32_t>(size_t(width) * height * 4) };
+
+		uint8_t header[headerSize]{};
+		uint8_t* pOut{ header };
+		*pOut++ = 'B';
+		*pOut++ = 'M';
+		WriteLittleEndian(pOut, headerSize + imageSize, 4);
+		WriteLittleEndian(pOut, 0, 4);
+		WriteLittleEndian(pOut, headerSize, 4);
+
+		WriteLittleEndian(pOut, 40, 4);
+		WriteLittleEndian(pOut, static_cast<uint32_t>(width), 4);
+		WriteLittleEndian(pOut, static_cast<uint32_t>(-height), 4); //Negative height is top-down
+		WriteLittleEndian(pOut, 1, 2);
+		WriteLittleEndian(pOut, 32, 2);
+		WriteLittleEndian(pOut, 0, 4); //BI_RGB
+		WriteLittleEndian(pOut, imageSize, 4);
+
+		return static_cast<bool>(file.write(reinterpret_cast<const char*>(header), headerSize));
+	}
+}
+
+BatchRenderer::BatchRenderer(int width, int height, int threadCount, int bandHeight) :
+	m_Width{ width },
+	m_Height{ height },
+	m_ThreadCount{ threadCount },
+	m_BandHeight{ bandHeight > 0 && bandHeight < height ? bandHeight : 0 }
+{
+	if (m_ThreadCount <= 0)
+		m_ThreadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+bool BatchRenderer::LoadPoses(const std::string& filePath)
+{
+	std::ifstream file{ filePath };
+	if (!file)
+	{
+		std::cout << "Could not open pose file " << filePath << "\n";
+		return false;
+	}
+
+	std::string line{};
+	int lineNumber{};
+	while (std::getline(file, line))
+	{
+		++lineNumber;
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream stream{ line };
+		CameraPose pose{};
+		if (!(stream >> pose.origin.x >> pose.origin.y >> pose.origin.z >> pose.pitch >> pose.yaw))
+		{
+			std::cout << filePath << "(" << lineNumber << "): expected x y z pitch yaw [fov] [meshYaw]\n";
+			return false;
+		}
+
+		//Optional columns keep their defaults when missing, a failed extraction would zero them
+		float value{};
+		if (stream >> value)
+		{
+			pose.fovAngle = value;
+			if (stream >> value)
+				pose.meshYaw = value;
+		}
+
+		m_Poses.push_back(pose);
+	}
+
+	return true;
+}
+
+int BatchRenderer::Run(const std::string& outputDirectory, ImageFormat format) const
+{
+	std::error_code error{};
+	std::filesystem::create_directories(outputDirectory, error);
+	if (error)
+	{
+		std::cout << "Could not create output directory " << outputDirectory << ": " << error.message() << "\n";
+		return 0;
+	}
+
+	//Loaded once, every worker reads from the same meshes and textures
+	const std::shared_ptr<const Scene> pScene{ std::make_shared<const Scene>() };
+
+	const int poseCount{ static_cast<int>(m_Poses.size()) };
+	const int threadCount{ std::min(m_ThreadCount, std::max(poseCount, 1)) };
+
+	std::atomic<int> nextFrame{};
+	std::atomic<int> savedFrames{};
+	//Every finished pose is a profiler frame, EndFrame expects one caller at a time
+	std::mutex endFrameMutex{};
+
+	//Two buffers per worker so a renderer only waits when encoding falls behind
+	CaptureQueue captureQueue{ threadCount * 2, threadCount };
+	const CaptureQueue::Callback onSaved{ [&savedFrames](const std::string& filePath, bool isSaved)
+		{
+			if (isSaved)
+				++savedFrames;
+			else
+				std::cout << "Could not save " << filePath << "\n";
+		} };
+
+	if (m_BandHeight > 0 && format != ImageFormat::BMP)
+		std::cout << "Frames rendered in bands are written as BMP\n";
+
+	const auto startTime{ std::chrono::steady_clock::now() };
+
+	std::vector<std::thread> workers{};
+	workers.reserve(threadCount);
+	for (int i{}; i < threadCount; ++i)
+	{
+		workers.emplace_back([&]
+			{
+				PROFILE_THREAD_NAME("BatchWorker");
+				Renderer renderer{ m_Width, m_BandHeight > 0 ? m_BandHeight : m_Height, pScene };
+				renderer.SetLodError(m_LodPixelError);
+
+				//Frames are handed out one at a time so slow poses don't stall a whole worker
+				for (int frame{ nextFrame++ }; frame < poseCount; frame = nextFrame++)
+				{
+					const CameraPose& pose{ m_Poses[frame] };
+					if (m_BandHeight > 0)
+					{
+						char fileName[32]{};
+						snprintf(fileName, sizeof(fileName), "frame_%05d.bmp", frame);
+						const std::string filePath{ (std::filesystem::path{ outputDirectory } / fileName).string() };
+						onSaved(filePath, RenderBands(renderer, pose, filePath));
+
+						std::lock_guard lock{ endFrameMutex };
+						PROFILE_END_FRAME();
+						continue;
+					}
+
+					renderer.SetCamera(pose.origin, pose.pitch, pose.yaw, pose.fovAngle);
+					renderer.SetMeshRotation(pose.meshYaw);
+					renderer.Render();
+
+					char fileName[32]{};
+					snprintf(fileName, sizeof(fileName), "frame_%05d%s", frame, GetExtension(format));
+					const std::string filePath{ (std::filesystem::path{ outputDirectory } / fileName).string() };
+
+					captureQueue.Submit(renderer.GetPixels(), m_Width, m_Height, m_Width, filePath, format, onSaved);
+
+					std::lock_guard lock{ endFrameMutex };
+					PROFILE_END_FRAME();
+				}
+			});
+	}
+
+	for (std::thread& worker : workers)
+		worker.join();
+	captureQueue.Flush();
+
+	const float totalTime{ std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() };
+	std::cout << savedFrames << "/" << poseCount << " frames on " << threadCount << " threads in " << totalTime
+		<< "s, FPS: " << (totalTime > 0.f ? savedFrames / totalTime : 0.f) << std::endl;
+
+	return savedFrames;
+}
+
+bool BatchRenderer::RenderBands(Renderer& renderer, const CameraPose& pose, const std::string& filePath) const
+{
+	std::ofstream file{ filePath, std::ios::binary };
+	if (!file)
+		return false;
+
+	//The camera takes its aspect ratio from the frame, not from the band
+	renderer.SetFrameRect(m_Width, m_Height, 0, 0);
+	renderer.SetCamera(pose.origin, pose.pitch, pose.yaw, pose.fovAngle);
+	renderer.SetMeshRotation(pose.meshYaw);
+
+	bool isWritten{ WriteBMPHeader(file, m_Width, m_Height) };
+	for (int bandY{}; bandY < m_Height && isWritten; bandY += m_BandHeight)
+	{
+		renderer.SetFrameRect(m_Width, m_Height, 0, bandY);
+		renderer.Render();
+
+		//Bands span the full width, so the rows are contiguous
+		const size_t pixelCount{ size_t(m_Width) * renderer.GetRenderHeight() };
+		isWritten = static_cast<bool>(file.write(reinterpret_cast<const char*>(renderer.GetPixels()), pixelCount * sizeof(uint32_t)));
+	}
+
+	file.close();
+	return isWritten && !file.fail();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+//Standard includes
+#include <string>
+#include <vector>
+
+//Project includes
+#include "CaptureQueue.h"
+#include "Math.h"
+
+namespace dae
+{
+	class Renderer;
+
+	//One frame of a batch, angles in degrees
+	struct CameraPose
+	{
+		Vector3 origin{};
+		float pitch{};
+		float yaw{};
+		float fovAngle{ 45.f };
+		float meshYaw{};
+	};
+
+	//Renders a list of camera poses offline to numbered images.
+	//Frames are independent, every worker thread owns a headless Renderer and all of them share one Scene.
+	//With a band height the Renderers only hold that many rows and every frame is rendered top to bottom in bands
+	//that are streamed to a BMP, which keeps the memory per worker small enough for 8K stills.
+	class BatchRenderer final
+	{
+	public:
+		BatchRenderer(int width, int height, int threadCount, int bandHeight = 0);
+		~BatchRenderer() = default;
+
+		BatchRenderer(const BatchRenderer&) = delete;
+		BatchRenderer(BatchRenderer&&) noexcept = delete;
+		BatchRenderer& operator=(const BatchRenderer&) = delete;
+		BatchRenderer& operator=(BatchRenderer&&) noexcept = delete;
+
+		//One pose per line: x y z pitch yaw [fov] [meshYaw], lines starting with # are skipped
+		bool LoadPoses(const std::string& filePath);
+		//Writes frame_00000, frame_00001, ... and returns how many frames were saved. Encoding overlaps with rendering.
+		int Run(const std::string& outputDirectory, ImageFormat format = ImageFormat::BMP) const;
+
+		size_t GetPoseCount() const { return m_Poses.size(); }
+		//Passed on to every worker's Renderer, see Renderer::SetLodError
+		void SetLodError(float maxPixelError) { m_LodPixelError = maxPixelError; }
+
+	private:
+		int m_Width{};
+		int m_Height{};
+		int m_ThreadCount{};
+		int m_BandHeight{};
+		float m_LodPixelError{ 1.f };
+
+		std::vector<CameraPose> m_Poses{};
+
+		bool RenderBands(Renderer& renderer, const CameraPose& pose, const std::string& filePath) const;
+	};
+}
@@ -0,0 +1,457 @@
+//External includes
+#include "SDL.h"
+#undef main
+
+//Standard includes
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <latch>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Project includes
+#include "BatchRenderer.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Utils.h"
+
+using namespace dae;
+
+//Renders scripted camera paths with a fixed timestep and reports frame and stage times as JSON.
+//Nothing depends on input or the wall clock, the same arguments render the same frames on every machine.
+namespace
+{
+	//Poses are spread evenly over the duration and interpolated, the path loops
+	struct CameraPath
+	{
+		const char* pName{};
+		float duration{};
+		std::vector<CameraPose> poses{};
+
+		CameraPose Evaluate(float time) const
+		{
+			const float position{ std::fmod(time, duration) / duration * (poses.size() - 1) };
+			const size_t index{ std::min(static_cast<size_t>(position), poses.size() - 2) };
+			const float t{ position - index };
+			const CameraPose& from{ poses[index] };
+			const CameraPose& to{ poses[index + 1] };
+
+			CameraPose pose{};
+			pose.origin = from.origin + (to.origin - from.origin) * t;
+			pose.pitch = std::lerp(from.pitch, to.pitch, t);
+			pose.yaw = std::lerp(from.yaw, to.yaw, t);
+			pose.fovAngle = std::lerp(from.fovAngle, to.fovAngle, t);
+			pose.meshYaw = std::lerp(from.meshYaw, to.meshYaw, t);
+			return pose;
+		}
+	};
+
+	struct SceneSetup
+	{
+		const char* pName{};
+		SceneContent content{};
+		std::vector<CameraPath> paths{};
+	};
+
+	CameraPose MakePose(const Vector3& origin, float meshYaw)
+	{
+		CameraPose pose{};
+		pose.origin = origin;
+		pose.meshYaw = meshYaw;
+		return pose;
+	}
+
+	std::vector<SceneSetup> CreateSceneSetups()
+	{
+		//The meshes turn in front of a fixed camera, the dollies move in until the closest parts fill the view
+		const CameraPath turntable{ "turntable", 8.f, { MakePose({}, 0.f), MakePose({}, 360.f) } };
+		const CameraPath vehicleDolly{ "dolly", 6.f, { MakePose({}, 0.f), MakePose({ 0.f, 0.f, 25.f }, 30.f), MakePose({}, 0.f) } };
+		const CameraPath tuktukDolly{ "dolly", 6.f, { MakePose({}, 0.f), MakePose({ 0.f, 0.f, 6.f }, 30.f), MakePose({}, 0.f) } };
+		//Generated scenes only tilt, turned further they leave the view
+		const CameraPath sway{ "sway", 4.f, { MakePose({}, 0.f), MakePose({}, 15.f), MakePose({}, -15.f), MakePose({}, 0.f) } };
+
+		return {
+			SceneSetup{ "vehicle", SceneContent::Vehicle, { turntable, vehicleDolly } },
+			SceneSetup{ "tuktuk", SceneContent::TukTuk, { turntable, tuktukDolly } },
+			SceneSetup{ "triangles", SceneContent::TriangleField, { sway } },
+			SceneSetup{ "overdraw", SceneContent::Overdraw, { sway } }
+		};
+	}
+
+	struct RenderPathName
+	{
+		const char* pName;
+		RenderPath path;
+	};
+
+	constexpr RenderPathName RenderPathNames[]
+	{
+		{ "W1_Part1", RenderPath::W1_Part1 },
+		{ "W1_Part2", RenderPath::W1_Part2 },
+		{ "W1_Part3", RenderPath::W1_Part3 },
+		{ "W1_Part4", RenderPath::W1_Part4 },
+		{ "W1_Part5", RenderPath::W1_Part5 },
+		{ "W2_Part1", RenderPath::W2_Part1 },
+		{ "W2_Part2", RenderPath::W2_Part2 },
+		{ "W2_Part3", RenderPath::W2_Part3 },
+		{ "W3_Part1", RenderPath::W3_Part1 },
+		{ "W4_Part1", RenderPath::W4_Part1 }
+	};
+
+	struct Settings
+	{
+		std::vector<std::string> scenes{ "vehicle", "tuktuk", "triangles", "overdraw" };
+		std::vector<std::pair<int, int>> resolutions{ { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+		std::vector<int> threadCounts{ 1, std::max(1, static_cast<int>(std::thread::hardware_concurrency())) };
+		std::vector<RenderPathName> renderPaths{ RenderPathNames[std::size(RenderPathNames) - 1] };
+		int frameCount{ 240 };
+		int warmupFrames{ 10 };
+		float timestep{ 1.f / 60.f };
+		std::string outputPath{ "benchmark.json" };
+	};
+
+	//Milliseconds per frame of every stage, "Frame" is the whole Render call
+	using StageSamples = std::map<std::string, std::vector<double>>;
+
+	struct RunResult
+	{
+		std::string scene{};
+		std::string camera{};
+		const char* pRenderPath{};
+		int width{};
+		int height{};
+		int threadCount{};
+		double framesPerSecond{};
+		StageSamples stages{};
+		//Summed over the measured frames of every thread, only W4 counts them
+		RasterStatistics statistics{};
+		uint64_t statisticsFrames{};
+	};
+
+	void Accumulate(RasterStatistics& total, const RasterStatistics& frame)
+	{
+		total.trianglesSubmitted += frame.trianglesSubmitted;
+		total.trianglesFrustumCulled += frame.trianglesFrustumCulled;
+		total.trianglesOutsideRenderRect += frame.trianglesOutsideRenderRect;
+		total.trianglesBackfaceCulled += frame.trianglesBackfaceCulled;
+		total.trianglesRasterized += frame.trianglesRasterized;
+		total.boundingBoxPixels += frame.boundingBoxPixels;
+		total.boundingBoxPixelsRejected += frame.boundingBoxPixelsRejected;
+		total.pixelsTested += frame.pixelsTested;
+		total.pixelsDepthPassed += frame.pixelsDepthPassed;
+		total.shadingInvocations += frame.shadingInvocations;
+		total.pixelsShaded += frame.pixelsShaded;
+	}
+
+	std::vector<std::string> Split(const std::string& list)
+	{
+		std::vector<std::string> items{};
+		std::stringstream stream{ list };
+		std::string item{};
+		while (std::getline(stream, item, ','))
+		{
+			if (!item.empty())
+				items.push_back(item);
+		}
+		return items;
+	}
+
+	//WIDTHxHEIGHT, e.g. 1280x720
+	bool ParseResolution(const std::string& resolution, int& width, int& height)
+	{
+		const char* pEnd{ resolution.data() + resolution.size() };
+		const std::from_chars_result widthResult{ std::from_chars(resolution.data(), pEnd, width) };
+		if (widthResult.ec != std::errc{} || widthResult.ptr == pEnd || *widthResult.ptr != 'x')
+			return false;
+		const std::from_chars_result heightResult{ std::from_chars(widthResult.ptr + 1, pEnd, height) };
+		return heightResult.ec == std::errc{} && heightResult.ptr == pEnd;
+	}
+
+	//Every thread renders the whole path with its own Renderer, all of them share the scene
+	RunResult Run(const std::shared_ptr<const Scene>& pScene, const CameraPath& cameraPath, RenderPath renderPath, int width, int height, int threadCount, const Settings& settings)
+	{
+		RunResult result{};
+		std::mutex resultMutex{};
+		std::latch isReady{ threadCount + 1 };
+
+		std::vector<std::thread> workers{};
+		for (int i{}; i < threadCount; ++i)
+		{
+			workers.emplace_back([&]
+				{
+					PROFILE_THREAD_NAME("Benchmark");
+					Renderer renderer{ width, height, pScene };
+					renderer.SetRenderPath(renderPath);
+					isReady.arrive_and_wait();
+
+					StageSamples stages{};
+					RasterStatistics statistics{};
+#if DAE_PROFILING
+					std::vector<Profiler::ZoneTiming> zones{};
+					std::map<std::string, double> frameStages{};
+#endif
+					for (int frame{ -settings.warmupFrames }; frame < settings.frameCount; ++frame)
+					{
+						const CameraPose pose{ cameraPath.Evaluate(std::max(frame, 0) * settings.timestep) };
+						renderer.SetCamera(pose.origin, pose.pitch, pose.yaw, pose.fovAngle);
+						renderer.SetMeshRotation(pose.meshYaw);
+
+						const auto startTime{ std::chrono::steady_clock::now() };
+						renderer.Render();
+						const double frameTime{ std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() };
+
+#if DAE_PROFILING
+						//A zone can run more than once a frame, its time per frame is the sum
+						Profiler::TakeThreadZones(zones);
+						frameStages.clear();
+						for (const Profiler::ZoneTiming& zone : zones)
+							frameStages[zone.pName] += zone.seconds * 1000.0;
+#endif
+						if (frame < 0)
+							continue;
+
+						stages["Frame"].push_back(frameTime);
+						Accumulate(statistics, renderer.GetStatistics());
+#if DAE_PROFILING
+						for (const auto& [name, time] : frameStages)
+							stages[name].push_back(time);
+#endif
+					}
+
+					std::lock_guard lock{ resultMutex };
+					Accumulate(result.statistics, statistics);
+					result.statisticsFrames += settings.frameCount;
+					for (auto& [name, samples] : stages)
+						result.stages[name].insert(result.stages[name].end(), samples.begin(), samples.end());
+				});
+		}
+
+		isReady.arrive_and_wait();
+		const auto startTime{ std::chrono::steady_clock::now() };
+		for (std::thread& worker : workers)
+			worker.join();
+		const double totalTime{ std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() };
+
+		result.framesPerSecond = threadCount * static_cast<double>(settings.frameCount + settings.warmupFrames) / totalTime;
+		return result;
+	}
+
+	bool WriteResults(const std::string& filePath, const std::vector<RunResult>& results, const Settings& settings)
+	{
+		std::ofstream file{ filePath };
+		if (!file)
+			return false;
+
+		file << "{\n";
+		file << "  \"timestep\": " << settings.timestep << ",\n";
+		file << "  \"warmupFrames\": " << settings.warmupFrames << ",\n";
+		file << "  \"frames\": " << settings.frameCount << ",\n";
+		file << "  \"unit\": \"ms\",\n";
+		file << "  \"runs\": [";
+		for (size_t i{}; i < results.size(); ++i)
+		{
+			const RunResult& result{ results[i] };
+			file << (i == 0 ? "\n" : ",\n");
+			file << "    {\n";
+			file << "      \"scene\": \"" << result.scene << "\",\n";
+			file << "      \"camera\": \"" << result.camera << "\",\n";
+			file << "      \"renderPath\": \"" << result.pRenderPath << "\",\n";
+			file << "      \"width\": " << result.width << ",\n";
+			file << "      \"height\": " << result.height << ",\n";
+			file << "      \"threads\": " << result.threadCount << ",\n";
+			file << "      \"framesPerSecond\": " << result.framesPerSecond << ",\n";
+			file << "      \"stages\": {";
+
+			bool isFirstStage{ true };
+			for (const auto& [name, samples] : result.stages)
+			{
+				std::vector<double> sorted{ samples };
+				std::sort(sorted.begin(), sorted.end());
+				double total{};
+				for (const double sample : sorted)
+					total += sample;
+
+				file << (isFirstStage ? "\n" : ",\n");
+				file << "        \"" << name << "\": { \"frames\": " << sorted.size() << ", \"mean\": " << total / sorted.size()
+					<< ", \"p50\": " << Percentile(sorted.data(), sorted.size(), 50.0) << ", \"p95\": " << Percentile(sorted.data(), sorted.size(), 95.0)
+					<< ", \"p99\": " << Percentile(sorted.data(), sorted.size(), 99.0) << " }";
+				isFirstStage = false;
+			}
+			file << "\n      }";
+
+			if (result.statistics.trianglesSubmitted > 0)
+			{
+				//Mean per frame
+				const RasterStatistics& statistics{ result.statistics };
+				const double frames{ static_cast<double>(result.statisticsFrames) };
+				file << ",\n      \"statistics\": {\n";
+				file << "        \"trianglesSubmitted\": " << statistics.trianglesSubmitted / frames << ",\n";
+				file << "        \"trianglesFrustumCulled\": " << statistics.trianglesFrustumCulled / frames << ",\n";
+				file << "        \"trianglesOutsideRenderRect\": " << statistics.trianglesOutsideRenderRect / frames << ",\n";
+				file << "        \"trianglesBackfaceCulled\": " << statistics.trianglesBackfaceCulled / frames << ",\n";
+				file << "        \"trianglesRasterized\": " << statistics.trianglesRasterized / frames << ",\n";
+				file << "        \"boundingBoxPixels\": " << statistics.boundingBoxPixels / frames << ",\n";
+				file << "        \"boundingBoxPixelsRejected\": " << statistics.boundingBoxPixelsRejected / frames << ",\n";
+				file << "        \"pixelsTested\": " << statistics.pixelsTested / frames << ",\n";
+				file << "        \"pixelsDepthPassed\": " << statistics.pixelsDepthPassed / frames << ",\n";
+				file << "        \"pixelsShaded\": " << statistics.pixelsShaded / frames << ",\n";
+				file << "        \"shadingInvocations\": " << statistics.shadingInvocations / frames << "\n";
+				file << "      }";
+			}
+			file << "\n    }";
+		}
+		file << "\n  ]\n}\n";
+		return true;
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "Benchmark [options]\n"
+			<< "  --scenes <list>       vehicle,tuktuk,triangles,overdraw (default all of them)\n"
+			<< "  --resolutions <list>  e.g. 640x480,1920x1080 (default 640x480,1280x720,1920x1080)\n"
+			<< "  --threads <list>      Renderers rendering at the same time, e.g. 1,8 (default 1 and one per core)\n"
+			<< "  --paths <list>        Render functions to compare, W1_Part1 ... W4_Part1 or all (default W4_Part1)\n"
+			<< "  --frames <count>      Measured frames per run (default 240)\n"
+			<< "  --warmup <count>      Unmeasured frames before them (default 10)\n"
+			<< "  --timestep <seconds>  Camera path time between two frames (default 1/60)\n"
+			<< "  --output <path>       JSON results (default benchmark.json)\n";
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Settings settings{};
+	for (int i = 1; i < argc; ++i)
+	{
+		//Numbers are parsed whole, a malformed or out of range value prints the usage instead of throwing
+		bool isValid = true;
+		if (strcmp(args[i], "--scenes") == 0 && i + 1 < argc)
+			settings.scenes = Split(args[++i]);
+		else if (strcmp(args[i], "--resolutions") == 0 && i + 1 < argc)
+		{
+			settings.resolutions.clear();
+			for (const std::string& resolution : Split(args[++i]))
+			{
+				int width{}, height{};
+				if (!ParseResolution(resolution, width, height) || width <= 0 || height <= 0 || width > 8192 || height > 8192)
+				{
+					std::cout << "Resolution " << resolution << " has to be WIDTHxHEIGHT, at most 8192x8192" << std::endl;
+					return 1;
+				}
+				settings.resolutions.emplace_back(width, height);
+			}
+		}
+		else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc)
+		{
+			settings.threadCounts.clear();
+			for (const std::string& threadCount : Split(args[++i]))
+			{
+				int count{};
+				isValid = isValid && Utils::ParseNumber(threadCount.c_str(), count);
+				settings.threadCounts.push_back(std::max(1, count));
+			}
+		}
+		else if (strcmp(args[i], "--paths") == 0 && i + 1 < argc)
+		{
+			settings.renderPaths.clear();
+			for (const std::string& name : Split(args[++i]))
+			{
+				for (const RenderPathName& renderPath : RenderPathNames)
+				{
+					if (name == "all" || name == renderPath.pName)
+						settings.renderPaths.push_back(renderPath);
+				}
+			}
+		}
+		else if (strcmp(args[i], "--frames") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], settings.frameCount);
+		else if (strcmp(args[i], "--warmup") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], settings.warmupFrames);
+		else if (strcmp(args[i], "--timestep") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], settings.timestep);
+		else if (strcmp(args[i], "--output") == 0 && i + 1 < argc)
+			settings.outputPath = args[++i];
+		else
+		{
+			PrintUsage();
+			return strcmp(args[i], "--help") == 0 ? 0 : 1;
+		}
+
+		if (!isValid)
+		{
+			std::cout << "Invalid value " << args[i] << " for " << args[i - 1] << std::endl;
+			PrintUsage();
+			return 1;
+		}
+	}
+	settings.frameCount = std::max(1, settings.frameCount);
+	settings.warmupFrames = std::max(0, settings.warmupFrames);
+
+	if (settings.renderPaths.empty())
+	{
+		std::cout << "No known render path in --paths" << std::endl;
+		return 1;
+	}
+#if !DAE_PROFILING
+	std::cout << "Built with DAE_PROFILING=0, only whole frames are timed. Build the Profile configuration for the stages" << std::endl;
+#endif
+
+	std::vector<RunResult> results{};
+	for (const SceneSetup& setup : CreateSceneSetups())
+	{
+		if (std::find(settings.scenes.begin(), settings.scenes.end(), setup.pName) == settings.scenes.end())
+			continue;
+
+		//Loaded once, every run and every thread of a run draws the same assets
+		const auto pScene{ std::make_shared<const Scene>(setup.content) };
+		pScene->WaitUntilLoaded();
+
+		for (const CameraPath& cameraPath : setup.paths)
+		{
+			for (const RenderPathName& renderPath : settings.renderPaths)
+			{
+				for (const auto& [width, height] : settings.resolutions)
+				{
+					for (const int threadCount : settings.threadCounts)
+					{
+						RunResult result{ Run(pScene, cameraPath, renderPath.path, width, height, threadCount, settings) };
+						result.scene = setup.pName;
+						result.camera = cameraPath.pName;
+						result.pRenderPath = renderPath.pName;
+						result.width = width;
+						result.height = height;
+						result.threadCount = threadCount;
+
+						std::vector<double> frameTimes{ result.stages["Frame"] };
+						std::sort(frameTimes.begin(), frameTimes.end());
+						std::cout << result.scene << " " << result.camera << " " << result.pRenderPath << " " << width << "x" << height << " on " << threadCount
+							<< (threadCount == 1 ? " thread" : " threads") << ": p50 " << Percentile(frameTimes.data(), frameTimes.size(), 50.0) << " ms, p99 " << Percentile(frameTimes.data(), frameTimes.size(), 99.0)
+							<< " ms, " << result.framesPerSecond << " FPS" << std::endl;
+						results.push_back(std::move(result));
+					}
+				}
+			}
+		}
+	}
+
+	SDL_Quit();
+
+	if (!WriteResults(settings.outputPath, results, settings))
+	{
+		std::cout << "Could not write " << settings.outputPath << std::endl;
+		return 1;
+	}
+	std::cout << results.size() << " runs saved to " << settings.outputPath << std::endl;
+	return 0;
+}
@@ -0,0 +1,218 @@
+//External includes
+#include "SDL.h"
+#include "SDL_image.h"
+#include "SDL_surface.h"
+
+//Standard includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+//Project includes
+#include "CaptureQueue.h"
+#include "Profiler.h"
+
+using namespace dae;
+
+CaptureQueue::CaptureQueue(int capacity, int workerCount) :
+	m_Jobs(std::max(capacity, 1))
+{
+	for (int i{}; i < static_cast<int>(m_Jobs.size()); ++i)
+		m_FreeJobs.push_back(i);
+
+	for (int i{}; i < std::max(workerCount, 1); ++i)
+		m_Workers.emplace_back(&CaptureQueue::EncodeLoop, this);
+}
+
+CaptureQueue::~CaptureQueue()
+{
+	//Whatever was submitted still gets written
+	Flush();
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsRunning = false;
+	}
+	m_Condition.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+void CaptureQueue::Submit(const uint32_t* pPixels, int width, int height, int pitch, const std::string& filePath, ImageFormat format, Callback onComplete)
+{
+	int jobIndex{};
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this] { return !m_FreeJobs.empty(); });
+		jobIndex = m_FreeJobs.front();
+		m_FreeJobs.pop_front();
+	}
+
+	//Only this thread owns the job until it is queued, copy without holding the lock
+	Job& job{ m_Jobs[jobIndex] };
+	job.pixels.resize(size_t(width) * height);
+	for (int y{}; y < height; ++y)
+		memcpy(job.pixels.data() + size_t(y) * width, pPixels + size_t(y) * pitch, size_t(width) * sizeof(uint32_t));
+	job.width = width;
+	job.height = height;
+	job.filePath = filePath;
+	job.format = format;
+	job.onComplete = std::move(onComplete);
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_QueuedJobs.push_back(jobIndex);
+	}
+	m_Condition.notify_all();
+}
+
+void CaptureQueue::Flush()
+{
+	std::unique_lock lock{ m_Mutex };
+	m_Condition.wait(lock, [this] { return m_QueuedJobs.empty() && m_EncodingCount == 0; });
+}
+
+void CaptureQueue::EncodeLoop()
+{
+	PROFILE_THREAD_NAME("CaptureQueue");
+	while (true)
+	{
+		int jobIndex{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this] { return !m_QueuedJobs.empty() || !m_IsRunning; });
+			if (m_QueuedJobs.empty())
+				return;
+
+			jobIndex = m_QueuedJobs.front();
+			m_QueuedJobs.pop_front();
+			++m_EncodingCount;
+		}
+
+		Job& job{ m_Jobs[jobIndex] };
+		bool isSaved{};
+		{
+			PROFILE_ZONE("Encode");
+			isSaved = Encode(job);
+		}
+		if (job.onComplete)
+			job.onComplete(job.filePath, isSaved);
+		job.onComplete = {};
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_FreeJobs.push_back(jobIndex);
+			--m_EncodingCount;
+		}
+		m_Condition.notify_all();
+	}
+}
+
+bool CaptureQueue::Encode(const Job& job)
+{
+	if (job.format == ImageFormat::QOI)
+		return SaveQOI(job);
+
+	SDL_Surface* pSurface{ SDL_CreateRGBSurfaceFrom(const_cast<uint32_t*>(job.pixels.data()), job.width, job.height, 32, job.width * 4,
+		0x00FF0000, 0x0000FF00, 0x000000FF, 0) };
+	if (!pSurface)
+		return false;
+
+	const int result{ job.format == ImageFormat::PNG ? IMG_SavePNG(pSurface, job.filePath.c_str()) : SDL_SaveBMP(pSurface, job.filePath.c_str()) };
+	SDL_FreeSurface(pSurface);
+	return result == 0;
+}
+
+//https://qoiformat.org/qoi-specification.pdf
+//Lossless and several times faster to encode than PNG, alpha is always opaque here so QOI_OP_RGBA is never needed
+bool CaptureQueue::SaveQOI(const Job& job)
+{
+	const size_t pixelCount{ job.pixels.size() };
+
+	std::vector<uint8_t> bytes{};
+	bytes.reserve(14 + pixelCount * 4 + 8);
+
+	const auto writeBigEndian = [&bytes](uint32_t value)
+		{
+			bytes.push_back(static_cast<uint8_t>(value >> 24));
+			bytes.push_back(static_cast<uint8_t>(value >> 16));
+			bytes.push_back(static_cast<uint8_t>(value >> 8));
+			bytes.push_back(static_cast<uint8_t>(value));
+		};
+
+	//Header: magic, size, 3 channels, sRGB
+	bytes.insert(bytes.end(), { 'q', 'o', 'i', 'f' });
+	writeBigEndian(static_cast<uint32_t>(job.width));
+	writeBigEndian(static_cast<uint32_t>(job.height));
+	bytes.push_back(3);
+	bytes.push_back(0);
+
+	uint32_t seenPixels[64]{};
+	uint32_t previous{ 0xFF000000 };
+	int run{};
+
+	for (size_t i{}; i < pixelCount; ++i)
+	{
+		const uint32_t pixel{ job.pixels[i] | 0xFF000000 };
+
+		if (pixel == previous)
+		{
+			++run;
+			if (run == 62 || i + 1 == pixelCount)
+			{
+				bytes.push_back(static_cast<uint8_t>(0xC0 | (run - 1)));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0)
+		{
+			bytes.push_back(static_cast<uint8_t>(0xC0 | (run - 1)));
+			run = 0;
+		}
+
+		const uint8_t r{ static_cast<uint8_t>(pixel >> 16) };
+		const uint8_t g{ static_cast<uint8_t>(pixel >> 8) };
+		const uint8_t b{ static_cast<uint8_t>(pixel) };
+
+		const int hash{ (r * 3 + g * 5 + b * 7 + 255 * 11) % 64 };
+		if (seenPixels[hash] == pixel)
+		{
+			bytes.push_back(static_cast<uint8_t>(hash));
+		}
+		else
+		{
+			seenPixels[hash] = pixel;
+
+			//Differences wrap around like the reference encoder
+			const int8_t dr{ static_cast<int8_t>(r - static_cast<uint8_t>(previous >> 16)) };
+			const int8_t dg{ static_cast<int8_t>(g - static_cast<uint8_t>(previous >> 8)) };
+			const int8_t db{ static_cast<int8_t>(b - static_cast<uint8_t>(previous)) };
+			const int8_t drg{ static_cast<int8_t>(dr - dg) };
+			const int8_t dbg{ static_cast<int8_t>(db - dg) };
+
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+			{
+				bytes.push_back(static_cast<uint8_t>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+			}
+			else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+			{
+				bytes.push_back(static_cast<uint8_t>(0x80 | (dg + 32)));
+				bytes.push_back(static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8)));
+			}
+			else
+			{
+				bytes.insert(bytes.end(), { 0xFE, r, g, b });
+			}
+		}
+
+		previous = pixel;
+	}
+
+	//End marker
+	bytes.insert(bytes.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+
+	std::ofstream file{ job.filePath, std::ios::binary };
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	return file.good();
+}
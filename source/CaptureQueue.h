@@ -0,0 +1,80 @@
+#pragma once
+
+//Standard includes
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	enum class ImageFormat
+	{
+		BMP,
+		PNG,
+		QOI
+	};
+
+	inline const char* GetExtension(ImageFormat format)
+	{
+		switch (format)
+		{
+		case ImageFormat::PNG: return ".png";
+		case ImageFormat::QOI: return ".qoi";
+		default: return ".bmp";
+		}
+	}
+
+	//Copies finished frames into pooled capture buffers and encodes them on worker threads, so saving never stalls rendering.
+	//The queue is bounded: when every buffer is waiting to be encoded Submit blocks instead of dropping the frame.
+	class CaptureQueue final
+	{
+	public:
+		//Called on a worker thread once the file is written (or failed to)
+		using Callback = std::function<void(const std::string& filePath, bool isSaved)>;
+
+		explicit CaptureQueue(int capacity = 4, int workerCount = 1);
+		~CaptureQueue();
+
+		CaptureQueue(const CaptureQueue&) = delete;
+		CaptureQueue(CaptureQueue&&) noexcept = delete;
+		CaptureQueue& operator=(const CaptureQueue&) = delete;
+		CaptureQueue& operator=(CaptureQueue&&) noexcept = delete;
+
+		//pPixels is 0x00RRGGBB like the Renderer's color targets, with pitch pixels from one row to the next.
+		//It can be reused as soon as this returns.
+		void Submit(const uint32_t* pPixels, int width, int height, int pitch, const std::string& filePath, ImageFormat format, Callback onComplete = {});
+		//Blocks until every submitted frame is written
+		void Flush();
+
+	private:
+		struct Job
+		{
+			std::vector<uint32_t> pixels{};
+			int width{};
+			int height{};
+			std::string filePath{};
+			ImageFormat format{};
+			Callback onComplete{};
+		};
+
+		std::vector<Job> m_Jobs{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::deque<int> m_FreeJobs{};
+		std::deque<int> m_QueuedJobs{};
+		int m_EncodingCount{};
+		bool m_IsRunning{ true };
+		std::vector<std::thread> m_Workers{};
+
+		void EncodeLoop();
+
+		static bool Encode(const Job& job);
+		static bool SaveQOI(const Job& job);
+	};
+}
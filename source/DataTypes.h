@@ -1,6 +1,8 @@
 #pragma once
 #include "Math.h"
 #include "vector"
+#include <memory>
+#include <span>
 
 namespace dae
 {
@@ -30,6 +32,95 @@ namespace dae
 		TriangleStrip
 	};
 
+	//In a TriangleStrip, ends the strip so far and starts a new one with the next index
+	constexpr uint32_t PrimitiveRestartIndex{ UINT32_MAX };
+
+	// Pixels per shading sample along each axis, depth and coverage stay per pixel
+	enum class ShadingRate
+	{
+		Rate1x1 = 1,
+		Rate2x2 = 2,
+		Rate4x4 = 4
+	};
+
+	class MappedFile;
+
+	//Vertex as MeshData stores it, 18 bytes instead of 68. The Renderer's vertex transform decodes it (see VertexPacking.h).
+	struct PackedVertex
+	{
+		uint16_t position[3]{}; //Unorm across MeshData's bounds
+		uint16_t uv[2]{}; //Half floats
+		int16_t normal[2]{}; //Octahedral, snorm
+		int16_t tangent[2]{}; //Octahedral, snorm
+	};
+
+	//Reads 16 or 32 bit indices as 32 bit, the 16 bit restart index (all bits set) reads as PrimitiveRestartIndex
+	struct IndexView
+	{
+		const uint16_t* pIndices16{};
+		const uint32_t* pIndices32{};
+		size_t count{};
+
+		size_t size() const { return count; }
+		uint32_t operator[](size_t i) const
+		{
+			if (pIndices16)
+				return pIndices16[i] == UINT16_MAX ? PrimitiveRestartIndex : pIndices16[i];
+			return pIndices32[i];
+		}
+	};
+
+	//One level of detail, a range of MeshData's vertices, colors and indices
+	struct MeshLod
+	{
+		uint64_t firstVertex{};
+		uint64_t vertexCount{};
+		//Relative to firstVertex
+		uint64_t firstIndex{};
+		uint64_t indexCount{};
+		//Roughly how far the surface lies from the full mesh, in object space
+		float error{};
+	};
+
+	//Read-only geometry, shared by every Mesh (and Renderer) that draws it
+	struct MeshData
+	{
+		//Level 0 is the full mesh, coarser further along
+		std::vector<MeshLod> lods{};
+
+		//Of every level
+		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleList };
+
+		//Object space bounds, the positions are quantized across them
+		Vector3 boundsMin{};
+		Vector3 boundsMax{};
+
+		std::span<const PackedVertex> vertices{};
+		//Empty when the asset has no vertex colors, they are white then
+		std::span<const ColorRGB> colors{};
+		//16 bit when every level has fewer than 65535 vertices, only one of them is set
+		std::span<const uint16_t> indices16{};
+		std::span<const uint32_t> indices32{};
+
+		//The spans point into the mapped mesh cache, or into container when the cache could not be written
+		std::shared_ptr<const MappedFile> pMappedFile{};
+		std::vector<uint8_t> container{};
+
+		int GetLevelCount() const { return static_cast<int>(lods.size()); }
+		std::span<const PackedVertex> GetVertices(int level = 0) const { return vertices.subspan(lods[level].firstVertex, lods[level].vertexCount); }
+		std::span<const ColorRGB> GetColors(int level = 0) const
+		{
+			return colors.empty() ? colors : colors.subspan(lods[level].firstVertex, lods[level].vertexCount);
+		}
+		IndexView GetIndices(int level = 0) const
+		{
+			const MeshLod& lod{ lods[level] };
+			if (!indices16.empty())
+				return IndexView{ indices16.data() + lod.firstIndex, nullptr, lod.indexCount };
+			return IndexView{ nullptr, indices32.data() + lod.firstIndex, lod.indexCount };
+		}
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
@@ -38,5 +129,48 @@ namespace dae
 
 		std::vector<Vertex_Out> vertices_out{};
 		Matrix worldMatrix{};
+
+		ShadingRate shadingRate{ ShadingRate::Rate1x1 };
+
+		//When set, used instead of vertices/indices
+		std::shared_ptr<const MeshData> pSharedData{};
+		//Level of pSharedData drawn this frame, picked by the Renderer
+		int lodLevel{};
+
+		IndexView GetIndices() const { return pSharedData ? pSharedData->GetIndices(lodLevel) : IndexView{ nullptr, indices.data(), indices.size() }; }
+		PrimitiveTopology GetPrimitiveTopology() const { return pSharedData ? pSharedData->primitiveTopology : primitiveTopology; }
+	};
+
+	// Structure of arrays holding up to Size fragments waiting to be shaded, lanes at or above count are unused
+	struct FragmentBatch
+	{
+		static constexpr int Size{ 8 };
+
+		alignas(32) float normalX[Size]{};
+		alignas(32) float normalY[Size]{};
+		alignas(32) float normalZ[Size]{};
+		alignas(32) float tangentX[Size]{};
+		alignas(32) float tangentY[Size]{};
+		alignas(32) float tangentZ[Size]{};
+		alignas(32) float u[Size]{};
+		alignas(32) float v[Size]{};
+		alignas(32) float viewDirectionX[Size]{};
+		alignas(32) float viewDirectionY[Size]{};
+		alignas(32) float viewDirectionZ[Size]{};
+
+		// Shading cell each lane writes to, bit (y * rate + x) of coverage is set for every pixel of the cell that passed the depth test
+		int cellX[Size]{};
+		int cellY[Size]{};
+		int rate[Size]{};
+		uint16_t coverage[Size]{};
+
+		int count{};
+	};
+
+	struct ColorBatch
+	{
+		alignas(32) float r[FragmentBatch::Size]{};
+		alignas(32) float g[FragmentBatch::Size]{};
+		alignas(32) float b[FragmentBatch::Size]{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+//Standard includes
+#include <algorithm>
+#include <cmath>
+
+//Project includes
+#include "DynamicResolution.h"
+
+using namespace dae;
+
+namespace
+{
+	//Over budget by more than this and the scale drops, under it by more than this and it rises
+	constexpr float g_OverBudget{ 1.02f };
+	constexpr float g_UnderBudget{ .8f };
+	//Aim a little below the target so the next heavier frame still fits
+	constexpr float g_Headroom{ .9f };
+	//Growing too fast overshoots and ends in oscillation, shrinking may be as fast as needed
+	constexpr float g_MaxGrowth{ 1.1f };
+}
+
+DynamicResolution::DynamicResolution(float targetFrameTime, float minScale, float maxScale) :
+	m_TargetFrameTime{ targetFrameTime },
+	m_MinScale{ std::clamp(minScale, ScaleStep, 1.f) },
+	m_MaxScale{ std::clamp(maxScale, m_MinScale, 1.f) },
+	m_Scale{ m_MaxScale }
+{
+}
+
+bool DynamicResolution::Update(float frameTime)
+{
+	m_History[m_HistoryIndex] = frameTime;
+	m_HistoryIndex = (m_HistoryIndex + 1) % HistorySize;
+	m_HistoryCount = std::min(m_HistoryCount + 1, HistorySize);
+	if (m_HistoryCount < SettleFrames)
+		return false;
+
+	const float smoothedFrameTime{ GetSmoothedFrameTime() };
+	if (smoothedFrameTime <= 0.f)
+		return false;
+
+	const float load{ smoothedFrameTime / m_TargetFrameTime };
+	if (load < g_OverBudget && load > g_UnderBudget)
+		return false;
+
+	//Frame time follows the pixel count, the scale is per axis
+	float scale{ m_Scale * std::sqrt(g_Headroom / load) };
+	scale = std::min(scale, m_Scale * g_MaxGrowth);
+	scale = std::round(scale / ScaleStep) * ScaleStep;
+	scale = std::clamp(scale, m_MinScale, m_MaxScale);
+	if (scale == m_Scale)
+		return false;
+
+	m_Scale = scale;
+	m_HistoryCount = 0;
+	m_HistoryIndex = 0;
+	return true;
+}
+
+float DynamicResolution::GetSmoothedFrameTime() const
+{
+	if (m_HistoryCount == 0)
+		return 0.f;
+
+	float totalTime{};
+	for (int i{}; i < m_HistoryCount; ++i)
+		totalTime += m_History[i];
+	return totalTime / m_HistoryCount;
+}
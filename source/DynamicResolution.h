@@ -0,0 +1,41 @@
+#pragma once
+
+namespace dae
+{
+	//Picks the internal render scale that keeps frames within a frame time budget.
+	//Decisions use the average of the last frames so a single hitch does not make the resolution jump,
+	//and after every change the history starts over because frames at the old size say nothing about the new one.
+	class DynamicResolution final
+	{
+	public:
+		//Times in seconds, scales are per axis relative to the window
+		explicit DynamicResolution(float targetFrameTime, float minScale = .5f, float maxScale = 1.f);
+		~DynamicResolution() = default;
+
+		DynamicResolution(const DynamicResolution&) = delete;
+		DynamicResolution(DynamicResolution&&) noexcept = delete;
+		DynamicResolution& operator=(const DynamicResolution&) = delete;
+		DynamicResolution& operator=(DynamicResolution&&) noexcept = delete;
+
+		//Adds the time of the last frame, true when the scale changed
+		bool Update(float frameTime);
+
+		float GetScale() const { return m_Scale; }
+		float GetTargetFrameTime() const { return m_TargetFrameTime; }
+		float GetSmoothedFrameTime() const;
+
+	private:
+		static constexpr int HistorySize{ 16 };
+		static constexpr int SettleFrames{ 8 }; //Frames at a new size before it is judged
+		static constexpr float ScaleStep{ 1.f / 32.f }; //Smaller changes are not worth a resize
+
+		float m_TargetFrameTime{};
+		float m_MinScale{};
+		float m_MaxScale{};
+		float m_Scale{};
+
+		float m_History[HistorySize]{};
+		int m_HistoryCount{};
+		int m_HistoryIndex{};
+	};
+}
@@ -0,0 +1,146 @@
+//External includes
+#include "SDL.h"
+#include "SDL_surface.h"
+
+//Project includes
+#include "FramePresenter.h"
+#include "Profiler.h"
+
+using namespace dae;
+
+FramePresenter::FramePresenter(SDL_Window* pWindow, const std::vector<SDL_Surface*>& targets) :
+	m_pWindow{ pWindow },
+	m_pFrontBuffer{ SDL_GetWindowSurface(pWindow) },
+	m_Targets{ targets }
+{
+	for (int i{}; i < static_cast<int>(m_Targets.size()); ++i)
+	{
+		m_FreeTargets.push_back(i);
+		m_FrameRects.push_back(SDL_Rect{ 0, 0, m_Targets[i]->w, m_Targets[i]->h });
+	}
+
+	if (m_Targets.size() > 1)
+		m_Thread = std::thread{ &FramePresenter::PresentLoop, this };
+}
+
+FramePresenter::~FramePresenter()
+{
+	if (!m_Thread.joinable())
+		return;
+
+	//Let the queued frames go out first
+	Flush();
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsRunning = false;
+	}
+	m_Condition.notify_all();
+	m_Thread.join();
+}
+
+void FramePresenter::UpdateWindow()
+{
+	std::unique_lock lock{ m_Mutex };
+	WaitUpdatingWindow(lock, [this] { return !m_IsWindowUpdatePending; });
+}
+
+int FramePresenter::AcquireTarget()
+{
+	//The present thread may be waiting on a window update before it frees a target
+	std::unique_lock lock{ m_Mutex };
+	WaitUpdatingWindow(lock, [this] { return !m_FreeTargets.empty(); });
+
+	const int targetIndex{ m_FreeTargets.front() };
+	m_FreeTargets.pop_front();
+	return targetIndex;
+}
+
+void FramePresenter::Present(int targetIndex, int width, int height)
+{
+	//The target belongs to the caller until it is queued
+	m_FrameRects[targetIndex] = SDL_Rect{ 0, 0, width, height };
+
+	if (!m_Thread.joinable())
+	{
+		Blit(targetIndex);
+		SDL_UpdateWindowSurface(m_pWindow);
+		std::lock_guard lock{ m_Mutex };
+		m_FreeTargets.push_back(targetIndex);
+		return;
+	}
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_QueuedTargets.push_back(targetIndex);
+	}
+	m_Condition.notify_all();
+}
+
+void FramePresenter::Flush()
+{
+	std::unique_lock lock{ m_Mutex };
+	WaitUpdatingWindow(lock, [this] { return m_QueuedTargets.empty() && !m_IsPresenting && !m_IsWindowUpdatePending; });
+}
+
+template<typename Predicate>
+void FramePresenter::WaitUpdatingWindow(std::unique_lock<std::mutex>& lock, Predicate isDone)
+{
+	while (!isDone())
+	{
+		if (!m_IsWindowUpdatePending)
+		{
+			m_Condition.wait(lock, [this, &isDone] { return isDone() || m_IsWindowUpdatePending; });
+			continue;
+		}
+
+		//The present thread leaves the front buffer alone while the update is pending
+		lock.unlock();
+		{
+			PROFILE_ZONE("UpdateWindow");
+			SDL_UpdateWindowSurface(m_pWindow);
+		}
+		lock.lock();
+		m_IsWindowUpdatePending = false;
+		m_Condition.notify_all();
+	}
+}
+
+void FramePresenter::PresentLoop()
+{
+	PROFILE_THREAD_NAME("FramePresenter");
+	while (true)
+	{
+		int targetIndex{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this] { return (!m_QueuedTargets.empty() && !m_IsWindowUpdatePending) || !m_IsRunning; });
+			if (m_QueuedTargets.empty())
+				return;
+
+			targetIndex = m_QueuedTargets.front();
+			m_QueuedTargets.pop_front();
+			m_IsPresenting = true;
+		}
+
+		Blit(targetIndex);
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_FreeTargets.push_back(targetIndex);
+			m_IsPresenting = false;
+			m_IsWindowUpdatePending = true;
+		}
+		m_Condition.notify_all();
+	}
+}
+
+void FramePresenter::Blit(int targetIndex)
+{
+	PROFILE_ZONE("Present");
+	SDL_Surface* pTarget{ m_Targets[targetIndex] };
+	const SDL_Rect& frameRect{ m_FrameRects[targetIndex] };
+	if (frameRect.w == m_pFrontBuffer->w && frameRect.h == m_pFrontBuffer->h)
+		SDL_BlitSurface(pTarget, &frameRect, m_pFrontBuffer, 0);
+	else
+		SDL_BlitScaled(pTarget, &frameRect, m_pFrontBuffer, 0);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+//Standard includes
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Surface;
+struct SDL_Rect;
+
+namespace dae
+{
+	//Hands finished color targets to a present thread that blits them so the next frame can render meanwhile.
+	//SDL only updates a window surface from the thread that created the window, so the blitted frame goes out
+	//in UpdateWindow (or while AcquireTarget and Flush wait) on the calling thread.
+	//With a single target there is nothing to overlap, Present then blits on the calling thread.
+	//A frame rendered at a lower resolution sits in the top left of its target and is stretched over the window.
+	class FramePresenter final
+	{
+	public:
+		FramePresenter(SDL_Window* pWindow, const std::vector<SDL_Surface*>& targets);
+		~FramePresenter();
+
+		FramePresenter(const FramePresenter&) = delete;
+		FramePresenter(FramePresenter&&) noexcept = delete;
+		FramePresenter& operator=(const FramePresenter&) = delete;
+		FramePresenter& operator=(FramePresenter&&) noexcept = delete;
+
+		//Shows the frame the present thread last blitted, if any, call from the window thread
+		void UpdateWindow();
+		//Blocks until a target is no longer queued or being presented
+		int AcquireTarget();
+		//width x height is the part of the target that holds the frame
+		void Present(int targetIndex, int width, int height);
+		//Blocks until every queued frame is on screen
+		void Flush();
+
+		size_t GetTargetCount() const { return m_Targets.size(); }
+
+	private:
+		SDL_Window* m_pWindow{};
+		SDL_Surface* m_pFrontBuffer{};
+		std::vector<SDL_Surface*> m_Targets{};
+		std::vector<SDL_Rect> m_FrameRects{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::deque<int> m_FreeTargets{};
+		std::deque<int> m_QueuedTargets{};
+		bool m_IsPresenting{ false };
+		bool m_IsWindowUpdatePending{ false }; //Front buffer holds a frame, the present thread does not touch it until it is shown
+		bool m_IsRunning{ true };
+		std::thread m_Thread{};
+
+		template<typename Predicate>
+		void WaitUpdatingWindow(std::unique_lock<std::mutex>& lock, Predicate isDone);
+		void PresentLoop();
+		void Blit(int targetIndex);
+	};
+}
@@ -0,0 +1,362 @@
+//Standard includes
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//Project includes
+#include "FrameStream.h"
+#include "Profiler.h"
+
+using namespace dae;
+
+namespace
+{
+	//BT.601 full range in 8 bit fixed point, matches the XCOLORRANGE=FULL in the Y4M header
+	inline uint8_t ToLuma(int r, int g, int b)
+	{
+		return static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+	}
+
+	//Saturated blue (U) and red (V) round up to 256, so both are clamped to the byte range
+	constexpr uint8_t ToChromaU(int r, int g, int b)
+	{
+		return static_cast<uint8_t>(std::clamp(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128, 0, 255));
+	}
+
+	constexpr uint8_t ToChromaV(int r, int g, int b)
+	{
+		return static_cast<uint8_t>(std::clamp(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128, 0, 255));
+	}
+
+	static_assert(ToChromaU(0, 0, 255) == 255 && ToChromaV(255, 0, 0) == 255, "Saturated chroma must not wrap around");
+
+#if defined(__AVX2__)
+	inline void SplitChannels(__m256i pixels, __m256i& r, __m256i& g, __m256i& b)
+	{
+		const __m256i byteMask{ _mm256_set1_epi32(0xFF) };
+		r = _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byteMask);
+		g = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask);
+		b = _mm256_and_si256(pixels, byteMask);
+	}
+
+	//Clamps the 8 lanes to 0..255 so StoreBytes does not wrap them
+	inline __m256i ClampToByte(__m256i values)
+	{
+		return _mm256_min_epi32(_mm256_max_epi32(values, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+	}
+
+	//Low byte of each of the 8 lanes, in order
+	inline void StoreBytes(uint8_t* pOut, __m256i values)
+	{
+		const __m256i lowBytes{ _mm256_setr_epi8(
+			0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1) };
+		const __m256i packed{ _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(values, lowBytes), _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1)) };
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(pOut), _mm256_castsi256_si128(packed));
+	}
+
+	//Sums horizontally adjacent pixel pairs of 16 pixels into 8 lanes, in order
+	inline __m256i SumPairs(__m256i first, __m256i second)
+	{
+		return _mm256_permute4x64_epi64(_mm256_hadd_epi32(first, second), 0b11'01'10'00);
+	}
+#endif
+}
+
+FrameStream::FrameStream(const std::string& target, int width, int height, StreamFormat format, int framesPerSecond, int bufferCount) :
+	m_IsStdout{ target == "-" },
+	m_Width{ width },
+	m_Height{ height },
+	m_Format{ format }
+{
+	if (m_IsStdout)
+	{
+		m_pFile = stdout;
+#if defined(_WIN32)
+		//Text mode would turn every 0x0A byte into 0x0D 0x0A
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	}
+	else
+	{
+		//Named pipes open like files, "\\\\.\\pipe\\name" on Windows or a mkfifo path elsewhere
+#if defined(_WIN32)
+		if (fopen_s(&m_pFile, target.c_str(), "wb") != 0)
+			m_pFile = nullptr;
+#else
+		m_pFile = fopen(target.c_str(), "wb");
+#endif
+	}
+
+	if (!m_pFile)
+	{
+		m_HasFailed = true;
+		return;
+	}
+
+#if !defined(_WIN32)
+	//A reader closing the pipe should end the stream, not the process
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	if (m_Format == StreamFormat::Y4M)
+	{
+		const size_t chromaSize{ size_t((m_Width + 1) / 2) * ((m_Height + 1) / 2) };
+		m_FrameSize = size_t(m_Width) * m_Height + chromaSize * 2;
+		fprintf(m_pFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", m_Width, m_Height, framesPerSecond);
+	}
+	else
+	{
+		m_FrameSize = size_t(m_Width) * m_Height * 4;
+	}
+
+	m_Buffers.resize(std::max(bufferCount, 1));
+	for (int i{}; i < static_cast<int>(m_Buffers.size()); ++i)
+	{
+		m_Buffers[i].resize(m_FrameSize);
+		m_FreeBuffers.push_back(i);
+	}
+
+	m_Thread = std::thread{ &FrameStream::WriteLoop, this };
+}
+
+FrameStream::~FrameStream()
+{
+	if (m_Thread.joinable())
+	{
+		//Queued frames still go out
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsRunning = false;
+		}
+		m_Condition.notify_all();
+		m_Thread.join();
+	}
+
+	if (m_pFile && !m_IsStdout)
+		fclose(m_pFile);
+	else if (m_pFile)
+		fflush(m_pFile);
+}
+
+bool FrameStream::IsOpen() const
+{
+	std::lock_guard lock{ m_Mutex };
+	return !m_HasFailed;
+}
+
+bool FrameStream::Submit(const uint32_t* pPixels)
+{
+	int bufferIndex{};
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this] { return !m_FreeBuffers.empty() || m_HasFailed; });
+		if (m_HasFailed)
+			return false;
+
+		bufferIndex = m_FreeBuffers.front();
+		m_FreeBuffers.pop_front();
+	}
+
+	//The conversion is the only copy, it writes straight into the buffer the writer thread hands to fwrite
+	Convert(pPixels, m_Buffers[bufferIndex].data());
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_QueuedBuffers.push_back(bufferIndex);
+	}
+	m_Condition.notify_all();
+	return true;
+}
+
+void FrameStream::WriteLoop()
+{
+	PROFILE_THREAD_NAME("FrameStream");
+	while (true)
+	{
+		int bufferIndex{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this] { return !m_QueuedBuffers.empty() || !m_IsRunning; });
+			if (m_QueuedBuffers.empty())
+				return;
+
+			bufferIndex = m_QueuedBuffers.front();
+			m_QueuedBuffers.pop_front();
+		}
+
+		PROFILE_ZONE("WriteFrame");
+		bool isWritten{ true };
+		if (m_Format == StreamFormat::Y4M)
+			isWritten = fwrite("FRAME\n", 1, 6, m_pFile) == 6;
+		isWritten = isWritten && fwrite(m_Buffers[bufferIndex].data(), 1, m_FrameSize, m_pFile) == m_FrameSize;
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_FreeBuffers.push_back(bufferIndex);
+			if (!isWritten)
+			{
+				//Reader is gone, drop what is left and wake up a blocked Submit
+				m_HasFailed = true;
+				m_QueuedBuffers.clear();
+			}
+		}
+		m_Condition.notify_all();
+	}
+}
+
+void FrameStream::Convert(const uint32_t* pPixels, uint8_t* pOut) const
+{
+	switch (m_Format)
+	{
+	case StreamFormat::BGRA:
+		ConvertToBGRA(pPixels, size_t(m_Width) * m_Height, pOut);
+		break;
+	case StreamFormat::RGBA:
+		ConvertToRGBA(pPixels, size_t(m_Width) * m_Height, pOut);
+		break;
+	case StreamFormat::Y4M:
+		ConvertToYUV420(pPixels, m_Width, m_Height, pOut);
+		break;
+	}
+}
+
+void FrameStream::ConvertToBGRA(const uint32_t* pPixels, size_t count, uint8_t* pOut)
+{
+	size_t i{};
+#if defined(__AVX2__)
+	//0x00RRGGBB is stored as B G R X already, the targets have no alpha channel so X is 0
+	const __m256i opaque{ _mm256_set1_epi32(static_cast<int>(0xFF000000)) };
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i pixels{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pPixels + i)) };
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pOut + i * 4), _mm256_or_si256(pixels, opaque));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		const uint32_t pixel{ pPixels[i] | 0xFF000000 };
+		memcpy(pOut + i * 4, &pixel, sizeof(pixel));
+	}
+}
+
+void FrameStream::ConvertToRGBA(const uint32_t* pPixels, size_t count, uint8_t* pOut)
+{
+	size_t i{};
+#if defined(__AVX2__)
+	//0x00RRGGBB is stored as B G R X, swap R and B and make it opaque
+	const __m256i swapRedBlue{ _mm256_setr_epi8(
+		2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1,
+		2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1) };
+	const __m256i opaque{ _mm256_set1_epi32(static_cast<int>(0xFF000000)) };
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i pixels{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pPixels + i)) };
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pOut + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(pixels, swapRedBlue), opaque));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		const uint32_t pixel{ pPixels[i] };
+		pOut[i * 4] = static_cast<uint8_t>(pixel >> 16);
+		pOut[i * 4 + 1] = static_cast<uint8_t>(pixel >> 8);
+		pOut[i * 4 + 2] = static_cast<uint8_t>(pixel);
+		pOut[i * 4 + 3] = 0xFF;
+	}
+}
+
+void FrameStream::ConvertToYUV420(const uint32_t* pPixels, int width, int height, uint8_t* pOut)
+{
+	const int chromaWidth{ (width + 1) / 2 };
+	const int chromaHeight{ (height + 1) / 2 };
+	uint8_t* pLuma{ pOut };
+	uint8_t* pChromaU{ pLuma + size_t(width) * height };
+	uint8_t* pChromaV{ pChromaU + size_t(chromaWidth) * chromaHeight };
+
+	//Y, one sample per pixel
+	for (int py{}; py < height; ++py)
+	{
+		const uint32_t* pRow{ pPixels + size_t(py) * width };
+		uint8_t* pLumaRow{ pLuma + size_t(py) * width };
+
+		int px{};
+#if defined(__AVX2__)
+		for (; px + 8 <= width; px += 8)
+		{
+			__m256i r{}, g{}, b{};
+			SplitChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow + px)), r, g, b);
+
+			__m256i luma{ _mm256_add_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(77)), _mm256_mullo_epi32(g, _mm256_set1_epi32(150))) };
+			luma = _mm256_add_epi32(luma, _mm256_add_epi32(_mm256_mullo_epi32(b, _mm256_set1_epi32(29)), _mm256_set1_epi32(128)));
+			StoreBytes(pLumaRow + px, _mm256_srli_epi32(luma, 8));
+		}
+#endif
+		for (; px < width; ++px)
+		{
+			const uint32_t pixel{ pRow[px] };
+			pLumaRow[px] = ToLuma((pixel >> 16) & 0xFF, (pixel >> 8) & 0xFF, pixel & 0xFF);
+		}
+	}
+
+	//U and V, one sample per 2x2 block, the last row/column is repeated for odd sizes
+	for (int cy{}; cy < chromaHeight; ++cy)
+	{
+		const uint32_t* pRow0{ pPixels + size_t(cy * 2) * width };
+		const uint32_t* pRow1{ pPixels + size_t(std::min(cy * 2 + 1, height - 1)) * width };
+		uint8_t* pRowU{ pChromaU + size_t(cy) * chromaWidth };
+		uint8_t* pRowV{ pChromaV + size_t(cy) * chromaWidth };
+
+		int cx{};
+#if defined(__AVX2__)
+		for (; cx * 2 + 16 <= width; cx += 8)
+		{
+			__m256i r0{}, g0{}, b0{}, r1{}, g1{}, b1{}, r2{}, g2{}, b2{}, r3{}, g3{}, b3{};
+			SplitChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + cx * 2)), r0, g0, b0);
+			SplitChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + cx * 2 + 8)), r1, g1, b1);
+			SplitChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + cx * 2)), r2, g2, b2);
+			SplitChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + cx * 2 + 8)), r3, g3, b3);
+
+			const __m256i two{ _mm256_set1_epi32(2) };
+			const __m256i r{ _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(SumPairs(r0, r1), SumPairs(r2, r3)), two), 2) };
+			const __m256i g{ _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(SumPairs(g0, g1), SumPairs(g2, g3)), two), 2) };
+			const __m256i b{ _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(SumPairs(b0, b1), SumPairs(b2, b3)), two), 2) };
+
+			const __m256i bias{ _mm256_set1_epi32(128) };
+			__m256i u{ _mm256_sub_epi32(_mm256_mullo_epi32(b, _mm256_set1_epi32(128)), _mm256_mullo_epi32(r, _mm256_set1_epi32(43))) };
+			u = _mm256_sub_epi32(_mm256_add_epi32(u, bias), _mm256_mullo_epi32(g, _mm256_set1_epi32(85)));
+			__m256i v{ _mm256_sub_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(128)), _mm256_mullo_epi32(g, _mm256_set1_epi32(107))) };
+			v = _mm256_sub_epi32(_mm256_add_epi32(v, bias), _mm256_mullo_epi32(b, _mm256_set1_epi32(21)));
+
+			StoreBytes(pRowU + cx, ClampToByte(_mm256_add_epi32(_mm256_srai_epi32(u, 8), bias)));
+			StoreBytes(pRowV + cx, ClampToByte(_mm256_add_epi32(_mm256_srai_epi32(v, 8), bias)));
+		}
+#endif
+		for (; cx < chromaWidth; ++cx)
+		{
+			const int x0{ cx * 2 };
+			const int x1{ std::min(x0 + 1, width - 1) };
+			const uint32_t pixels[4]{ pRow0[x0], pRow0[x1], pRow1[x0], pRow1[x1] };
+
+			int r{ 2 }, g{ 2 }, b{ 2 };
+			for (const uint32_t pixel : pixels)
+			{
+				r += (pixel >> 16) & 0xFF;
+				g += (pixel >> 8) & 0xFF;
+				b += pixel & 0xFF;
+			}
+			r >>= 2;
+			g >>= 2;
+			b >>= 2;
+
+			pRowU[cx] = ToChromaU(r, g, b);
+			pRowV[cx] = ToChromaV(r, g, b);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+//Standard includes
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	enum class StreamFormat
+	{
+		BGRA, //The back buffer bytes with an opaque alpha, ffmpeg -f rawvideo -pix_fmt bgra
+		RGBA, //ffmpeg -f rawvideo -pix_fmt rgba
+		Y4M //YUV 4:2:0 with a header, readable by most encoders without extra arguments
+	};
+
+	//Writes every frame it is given to stdout ("-"), a file or a named pipe so an external encoder can consume them live.
+	//Frames are converted into pooled buffers and written by a writer thread. When the reader falls behind
+	//every buffer fills up and Submit blocks, frames are never dropped.
+	class FrameStream final
+	{
+	public:
+		FrameStream(const std::string& target, int width, int height, StreamFormat format, int framesPerSecond = 60, int bufferCount = 3);
+		~FrameStream();
+
+		FrameStream(const FrameStream&) = delete;
+		FrameStream(FrameStream&&) noexcept = delete;
+		FrameStream& operator=(const FrameStream&) = delete;
+		FrameStream& operator=(FrameStream&&) noexcept = delete;
+
+		//False when the target could not be opened or the reader went away
+		bool IsOpen() const;
+		bool IsStdout() const { return m_IsStdout; }
+
+		//pPixels is 0x00RRGGBB without padding, like the Renderer's color targets. It can be reused as soon as this returns.
+		bool Submit(const uint32_t* pPixels);
+
+	private:
+		FILE* m_pFile{};
+		bool m_IsStdout{};
+		int m_Width{};
+		int m_Height{};
+		StreamFormat m_Format{};
+		size_t m_FrameSize{};
+
+		std::vector<std::vector<uint8_t>> m_Buffers{};
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::deque<int> m_FreeBuffers{};
+		std::deque<int> m_QueuedBuffers{};
+		bool m_HasFailed{ false };
+		bool m_IsRunning{ true };
+		std::thread m_Thread{};
+
+		void WriteLoop();
+		void Convert(const uint32_t* pPixels, uint8_t* pOut) const;
+
+		static void ConvertToBGRA(const uint32_t* pPixels, size_t count, uint8_t* pOut);
+		static void ConvertToRGBA(const uint32_t* pPixels, size_t count, uint8_t* pOut);
+		static void ConvertToYUV420(const uint32_t* pPixels, int width, int height, uint8_t* pOut);
+	};
+}
@@ -0,0 +1,122 @@
+//Standard includes
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+//Project includes
+#include "MappedFile.h"
+
+using namespace dae;
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+#if defined(_WIN32)
+	const HANDLE file{ CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+	m_IsOpen = true;
+	//A mapping of an empty file fails, there is nothing to map anyway
+	if (m_Size > 0)
+	{
+		m_Handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_Handle)
+			m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_Handle, FILE_MAP_READ, 0, 0, 0));
+		m_IsOpen = m_pData != nullptr;
+	}
+	CloseHandle(file);
+#else
+	const int file{ open(filePath.c_str(), O_RDONLY) };
+	if (file < 0)
+		return;
+
+	struct stat fileInfo{};
+	if (fstat(file, &fileInfo) != 0)
+	{
+		close(file);
+		return;
+	}
+
+	m_Size = static_cast<size_t>(fileInfo.st_size);
+	m_IsOpen = true;
+	if (m_Size > 0)
+	{
+		void* pData{ mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0) };
+		if (pData != MAP_FAILED)
+		{
+			//Readers scan front to back
+			madvise(pData, m_Size, MADV_SEQUENTIAL);
+			m_pData = static_cast<const uint8_t*>(pData);
+		}
+		m_IsOpen = m_pData != nullptr;
+	}
+	close(file);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(_WIN32)
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_Handle)
+		CloseHandle(m_Handle);
+#else
+	if (m_pData)
+		munmap(const_cast<uint8_t*>(m_pData), m_Size);
+#endif
+}
+
+bool dae::IsSectionInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+{
+	return offset % CacheSectionAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+bool dae::WriteFileAtomically(const std::string& filePath, const std::vector<uint8_t>& data)
+{
+	//Unique per process and per call, so processes or loader threads writing the same cache never share a temp file
+	static std::atomic<uint32_t> s_WriteCount{};
+#if defined(_WIN32)
+	const unsigned long processId{ GetCurrentProcessId() };
+#else
+	const long processId{ static_cast<long>(getpid()) };
+#endif
+	const std::string tempPath{ filePath + "." + std::to_string(processId) + "." + std::to_string(s_WriteCount.fetch_add(1)) + ".tmp" };
+	std::error_code error{};
+	{
+		std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		file.close();
+		if (!file)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, filePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
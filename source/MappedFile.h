@@ -0,0 +1,42 @@
+#pragma once
+
+//Standard includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	//Read-only view of a whole file, pages are loaded by the OS as they are touched
+	class MappedFile final
+	{
+	public:
+		explicit MappedFile(const std::string& filePath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) noexcept = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+		//False when the file could not be opened, an empty file is open but has no data
+		bool IsOpen() const { return m_IsOpen; }
+		const uint8_t* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const uint8_t* m_pData{};
+		size_t m_Size{};
+		bool m_IsOpen{};
+		void* m_Handle{}; //Windows file mapping
+	};
+
+	//Cache files start every section on a cache line, so the data can be read in place from a MappedFile
+	constexpr size_t CacheSectionAlignment{ 64 };
+
+	//True when count elements at offset lie inside a file of fileSize bytes and offset starts a section
+	bool IsSectionInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize);
+	//Writes to a uniquely named file next to filePath and renames it over filePath, so a MappedFile never sees a half written file
+	bool WriteFileAtomically(const std::string& filePath, const std::vector<uint8_t>& data);
+}
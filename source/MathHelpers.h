@@ -1,5 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include <cstddef>
 
 namespace dae
 {
@@ -56,4 +59,17 @@ namespace dae
 		if (v > 1.f) return 1.f;
 		return v;
 	}
+
+	//Rounds value up to a multiple of alignment
+	inline size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//Nearest rank on count sorted samples, count has to be at least 1
+	inline double Percentile(const double* pSorted, size_t count, double percent)
+	{
+		const size_t rank{ static_cast<size_t>(std::ceil(percent / 100.0 * count)) };
+		return pSorted[std::clamp(rank, size_t{ 1 }, count) - 1];
+	}
 }
\ No newline at end of file
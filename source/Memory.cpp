@@ -0,0 +1,107 @@
+#include "Memory.h"
+#include "MathHelpers.h"
+
+//Standard includes
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace dae
+{
+	namespace Memory
+	{
+		namespace
+		{
+			constexpr size_t HugePageSize{ 2 * 1024 * 1024 };
+
+#if defined(_WIN32)
+			//Large pages need SeLockMemoryPrivilege, only granted when the account has "Lock pages in memory"
+			bool EnableLargePages()
+			{
+				HANDLE token{};
+				if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+					return false;
+
+				TOKEN_PRIVILEGES privileges{};
+				privileges.PrivilegeCount = 1;
+				privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+				const bool isEnabled{ LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+					&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+					&& GetLastError() == ERROR_SUCCESS };
+				CloseHandle(token);
+				return isEnabled && GetLargePageMinimum() > 0;
+			}
+#endif
+		}
+
+		void* AllocateAligned(size_t size, size_t alignment)
+		{
+			//aligned_alloc wants the size to be a multiple of the alignment
+			size = AlignUp(size, alignment);
+#if defined(_WIN32)
+			void* pMemory{ _aligned_malloc(size, alignment) };
+#else
+			void* pMemory{ std::aligned_alloc(alignment, size) };
+#endif
+			if (!pMemory)
+				throw std::bad_alloc{};
+			return pMemory;
+		}
+
+		void FreeAligned(void* pMemory)
+		{
+#if defined(_WIN32)
+			_aligned_free(pMemory);
+#else
+			std::free(pMemory);
+#endif
+		}
+
+		void* AllocatePages(size_t size)
+		{
+#if defined(_WIN32)
+			static const bool hasLargePages{ EnableLargePages() };
+			if (hasLargePages && size >= GetLargePageMinimum())
+			{
+				void* pMemory{ VirtualAlloc(nullptr, AlignUp(size, GetLargePageMinimum()), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE) };
+				if (pMemory)
+					return pMemory;
+			}
+
+			//Regular pages are 64 KB aligned
+			void* pMemory{ VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE) };
+			if (!pMemory)
+				throw std::bad_alloc{};
+			return pMemory;
+#else
+			if (size < HugePageSize)
+				return AllocateAligned(size);
+
+			//Transparent huge pages only back 2 MB aligned ranges, the kernel may still decline
+			void* pMemory{ AllocateAligned(size, HugePageSize) };
+#if defined(MADV_HUGEPAGE)
+			madvise(pMemory, AlignUp(size, HugePageSize), MADV_HUGEPAGE);
+#endif
+			return pMemory;
+#endif
+		}
+
+		void FreePages(void* pMemory)
+		{
+#if defined(_WIN32)
+			if (pMemory)
+				VirtualFree(pMemory, 0, MEM_RELEASE);
+#else
+			FreeAligned(pMemory);
+#endif
+		}
+	}
+}
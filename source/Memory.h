@@ -0,0 +1,31 @@
+#pragma once
+
+//Standard includes
+#include <cstddef>
+
+namespace dae
+{
+	namespace Memory
+	{
+		//Cache line aligned by default, release with FreeAligned
+		void* AllocateAligned(size_t size, size_t alignment = 64);
+		void FreeAligned(void* pMemory);
+
+		template<typename T>
+		T* AllocateAligned(size_t count, size_t alignment = 64)
+		{
+			return static_cast<T*>(AllocateAligned(count * sizeof(T), alignment));
+		}
+
+		//For frame sized buffers, backed by huge pages where the OS allows so an 8K target doesn't thrash the TLB.
+		//Falls back to regular pages, always at least cache line aligned. Release with FreePages.
+		void* AllocatePages(size_t size);
+		void FreePages(void* pMemory);
+
+		template<typename T>
+		T* AllocatePages(size_t count)
+		{
+			return static_cast<T*>(AllocatePages(count * sizeof(T)));
+		}
+	}
+}
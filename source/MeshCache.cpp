@@ -0,0 +1,276 @@
+//Standard includes
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+//Project includes
+#include "MeshCache.h"
+#include "DataTypes.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Utils.h"
+#include "VertexPacking.h"
+
+using namespace dae;
+
+namespace
+{
+	//Bump when the layout below or the way ParseOBJ builds vertices changes
+	constexpr uint32_t CacheVersion{ 5 };
+	constexpr char CacheMagic[4]{ 'D', 'A', 'E', 'M' };
+	//The full mesh and the levels of detail MeshSimplifier adds to it
+	constexpr uint32_t MaxLevelCount{ 16 };
+
+	struct CacheHeader
+	{
+		char magic[4]{};
+		uint32_t version{};
+		uint64_t sourceHash{};
+		uint32_t vertexSize{};
+		uint32_t isFlipped{};
+		uint32_t isOrderedForOverdraw{};
+		uint32_t primitiveTopology{};
+		uint32_t indexSize{};
+		uint32_t levelCount{};
+		uint32_t hasColors{};
+		uint32_t padding{};
+		uint64_t levelOffset{};
+		uint64_t vertexCount{};
+		uint64_t vertexOffset{};
+		uint64_t colorOffset{};
+		uint64_t indexCount{};
+		uint64_t indexOffset{};
+		float boundsMin[3]{};
+		float boundsMax[3]{};
+	};
+
+	//Header of a cache matching the source and the load options, the sections are filled in by BuildContainer
+	CacheHeader CreateHeader(uint64_t sourceHash, bool flipAxisAndWinding, bool orderForOverdraw, bool buildStrips)
+	{
+		CacheHeader header{};
+		memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+		header.version = CacheVersion;
+		header.sourceHash = sourceHash;
+		header.vertexSize = sizeof(PackedVertex);
+		header.isFlipped = flipAxisAndWinding;
+		header.isOrderedForOverdraw = orderForOverdraw;
+		header.primitiveTopology = static_cast<uint32_t>(buildStrips ? PrimitiveTopology::TriangleStrip : PrimitiveTopology::TriangleList);
+		return header;
+	}
+
+	//Triangles in vertex cache order, optionally regrouped against overdraw and joined into strips, then the vertices in the order they are fetched.
+	//Returns the ACMR of the reordered triangles.
+	float OptimizeOrder(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool orderForOverdraw, bool buildStrips)
+	{
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		if (orderForOverdraw)
+			MeshOptimizer::OptimizeOverdraw(indices, vertices);
+		const float acmr{ MeshOptimizer::ComputeAcmr(indices, vertices.size()) };
+
+		if (buildStrips)
+			indices = MeshOptimizer::Stripify(indices, vertices.size());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+		return acmr;
+	}
+
+	//Header, level table, packed vertices, colors (when any vertex isn't white) and indices, exactly as the file is written.
+	//Indices are 16 bit when every level has fewer vertices than the 16 bit restart index.
+	std::vector<uint8_t> BuildContainer(CacheHeader header, const std::vector<MeshSimplifier::Level>& levels, const Vector3& boundsMin, const Vector3& boundsMax)
+	{
+		std::vector<MeshLod> lods{};
+		bool fitsIn16Bits{ true };
+		for (const MeshSimplifier::Level& level : levels)
+		{
+			lods.push_back(MeshLod{ header.vertexCount, level.vertices.size(), header.indexCount, level.indices.size(), level.error });
+			header.vertexCount += level.vertices.size();
+			header.indexCount += level.indices.size();
+			fitsIn16Bits = fitsIn16Bits && level.vertices.size() < UINT16_MAX;
+
+			for (const Vertex& vertex : level.vertices)
+			{
+				if (vertex.color.r != 1.f || vertex.color.g != 1.f || vertex.color.b != 1.f)
+					header.hasColors = true;
+			}
+		}
+
+		header.indexSize = fitsIn16Bits ? sizeof(uint16_t) : sizeof(uint32_t);
+		header.levelCount = static_cast<uint32_t>(levels.size());
+		header.levelOffset = AlignUp(sizeof(CacheHeader), CacheSectionAlignment);
+		header.vertexOffset = AlignUp(header.levelOffset + lods.size() * sizeof(MeshLod), CacheSectionAlignment);
+		header.colorOffset = AlignUp(header.vertexOffset + header.vertexCount * sizeof(PackedVertex), CacheSectionAlignment);
+		header.indexOffset = AlignUp(header.colorOffset + (header.hasColors ? header.vertexCount * sizeof(ColorRGB) : 0), CacheSectionAlignment);
+		memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+		memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+
+		std::vector<uint8_t> container(AlignUp(header.indexOffset + header.indexCount * header.indexSize, CacheSectionAlignment));
+		memcpy(container.data(), &header, sizeof(header));
+		memcpy(container.data() + header.levelOffset, lods.data(), lods.size() * sizeof(MeshLod));
+
+		PackedVertex* pVertices{ reinterpret_cast<PackedVertex*>(container.data() + header.vertexOffset) };
+		ColorRGB* pColors{ reinterpret_cast<ColorRGB*>(container.data() + header.colorOffset) };
+		uint8_t* pIndices{ container.data() + header.indexOffset };
+		for (const MeshSimplifier::Level& level : levels)
+		{
+			for (const Vertex& vertex : level.vertices)
+			{
+				*pVertices++ = VertexPacking::Pack(vertex, boundsMin, boundsMax);
+				if (header.hasColors)
+					*pColors++ = vertex.color;
+			}
+
+			for (const uint32_t index : level.indices)
+			{
+				if (fitsIn16Bits)
+				{
+					const uint16_t index16{ index == PrimitiveRestartIndex ? uint16_t{ UINT16_MAX } : static_cast<uint16_t>(index) };
+					memcpy(pIndices, &index16, sizeof(index16));
+				}
+				else
+					memcpy(pIndices, &index, sizeof(index));
+				pIndices += header.indexSize;
+			}
+		}
+		return container;
+	}
+
+	//Matches the expected header and every section and level lies inside the file
+	bool IsValidContainer(const uint8_t* pData, size_t size, const CacheHeader& expected)
+	{
+		if (size < sizeof(CacheHeader))
+			return false;
+
+		CacheHeader header{};
+		memcpy(&header, pData, sizeof(header));
+		if (memcmp(header.magic, expected.magic, sizeof(CacheMagic)) != 0
+			|| header.version != expected.version
+			|| header.sourceHash != expected.sourceHash
+			|| header.vertexSize != expected.vertexSize
+			|| header.isFlipped != expected.isFlipped
+			|| header.isOrderedForOverdraw != expected.isOrderedForOverdraw
+			|| header.primitiveTopology != expected.primitiveTopology
+			|| (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t))
+			|| header.levelCount == 0 || header.levelCount > MaxLevelCount)
+			return false;
+
+		if (!IsSectionInFile(header.levelOffset, header.levelCount, sizeof(MeshLod), size)
+			|| !IsSectionInFile(header.vertexOffset, header.vertexCount, sizeof(PackedVertex), size)
+			|| (header.hasColors && !IsSectionInFile(header.colorOffset, header.vertexCount, sizeof(ColorRGB), size))
+			|| !IsSectionInFile(header.indexOffset, header.indexCount, header.indexSize, size))
+			return false;
+
+		for (uint32_t level{}; level < header.levelCount; ++level)
+		{
+			MeshLod lod{};
+			memcpy(&lod, pData + header.levelOffset + level * sizeof(MeshLod), sizeof(lod));
+			if (lod.firstVertex > header.vertexCount || lod.vertexCount > header.vertexCount - lod.firstVertex
+				|| lod.firstIndex > header.indexCount || lod.indexCount > header.indexCount - lod.firstIndex)
+				return false;
+		}
+		return true;
+	}
+
+	//Welds the mesh, builds its levels of detail, reorders every level and packs them into a container for header
+	std::vector<uint8_t> ProcessMesh(MeshSimplifier::Level&& mesh, const CacheHeader& header, const std::string& name, bool buildLods)
+	{
+		const bool buildStrips{ header.primitiveTopology == static_cast<uint32_t>(PrimitiveTopology::TriangleStrip) };
+		MeshOptimizer::WeldVertices(mesh.vertices, mesh.indices);
+
+		//Simplifying is the slow part of a cold load, the cache keeps the result
+		std::vector<MeshSimplifier::Level> levels{};
+		if (buildLods)
+			levels = MeshSimplifier::BuildLods(mesh.vertices, mesh.indices);
+
+		const float fileOrderAcmr{ MeshOptimizer::ComputeAcmr(mesh.indices, mesh.vertices.size()) };
+		const size_t listIndexCount{ mesh.indices.size() };
+		const float acmr{ OptimizeOrder(mesh.vertices, mesh.indices, header.isOrderedForOverdraw, buildStrips) };
+		std::cout << name << ": ACMR " << fileOrderAcmr << " in file order, " << acmr << " optimized (" << MeshOptimizer::DefaultCacheSize << " entry cache)";
+		if (buildStrips)
+			std::cout << ", " << listIndexCount << " list indices as " << mesh.indices.size() << " in strips";
+		std::cout << "\n";
+
+		Vector3 boundsMin{}, boundsMax{};
+		if (!mesh.vertices.empty())
+		{
+			boundsMin = boundsMax = mesh.vertices.front().position;
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				boundsMin = { std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z) };
+				boundsMax = { std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z) };
+			}
+		}
+
+		for (MeshSimplifier::Level& level : levels)
+			OptimizeOrder(level.vertices, level.indices, header.isOrderedForOverdraw, buildStrips);
+		levels.insert(levels.begin(), std::move(mesh));
+		return BuildContainer(header, levels, boundsMin, boundsMax);
+	}
+
+	//Points the mesh's spans into a valid container, which lives in the mapping or is moved into the mesh
+	std::shared_ptr<const MeshData> CreateMesh(std::shared_ptr<const MappedFile> pMappedFile, std::vector<uint8_t>&& container)
+	{
+		const auto pMesh{ std::make_shared<MeshData>() };
+		pMesh->pMappedFile = std::move(pMappedFile);
+		pMesh->container = std::move(container);
+		const uint8_t* pData{ pMesh->pMappedFile ? pMesh->pMappedFile->GetData() : pMesh->container.data() };
+
+		CacheHeader header{};
+		memcpy(&header, pData, sizeof(header));
+		pMesh->lods.resize(header.levelCount);
+		memcpy(pMesh->lods.data(), pData + header.levelOffset, pMesh->lods.size() * sizeof(MeshLod));
+		pMesh->primitiveTopology = static_cast<PrimitiveTopology>(header.primitiveTopology);
+		memcpy(&pMesh->boundsMin, header.boundsMin, sizeof(header.boundsMin));
+		memcpy(&pMesh->boundsMax, header.boundsMax, sizeof(header.boundsMax));
+
+		const size_t vertexCount{ static_cast<size_t>(header.vertexCount) };
+		pMesh->vertices = { reinterpret_cast<const PackedVertex*>(pData + header.vertexOffset), vertexCount };
+		if (header.hasColors)
+			pMesh->colors = { reinterpret_cast<const ColorRGB*>(pData + header.colorOffset), vertexCount };
+		if (header.indexSize == sizeof(uint16_t))
+			pMesh->indices16 = { reinterpret_cast<const uint16_t*>(pData + header.indexOffset), size_t(header.indexCount) };
+		else
+			pMesh->indices32 = { reinterpret_cast<const uint32_t*>(pData + header.indexOffset), size_t(header.indexCount) };
+		return pMesh;
+	}
+}
+
+std::shared_ptr<const MeshData> MeshCache::LoadMesh(const std::string& objPath, bool flipAxisAndWinding, bool orderForOverdraw, bool buildStrips)
+{
+	uint64_t sourceHash{};
+	{
+		const MappedFile source{ objPath };
+		if (!source.IsOpen())
+			return nullptr;
+		sourceHash = Utils::HashBytes(source.GetData(), source.GetSize());
+	}
+
+	const CacheHeader expected{ CreateHeader(sourceHash, flipAxisAndWinding, orderForOverdraw, buildStrips) };
+	const std::string cachePath{ objPath + ".meshcache" };
+	auto pCache{ std::make_shared<const MappedFile>(cachePath) };
+	if (pCache->IsOpen() && IsValidContainer(pCache->GetData(), pCache->GetSize(), expected))
+		return CreateMesh(std::move(pCache), {});
+	//A stale cache stays mapped otherwise, and Windows refuses to rename over a mapped file
+	pCache.reset();
+
+	MeshSimplifier::Level mesh{};
+	if (!Utils::ParseOBJ(objPath, mesh.vertices, mesh.indices, flipAxisAndWinding))
+		return nullptr;
+
+	std::vector<uint8_t> container{ ProcessMesh(std::move(mesh), expected, objPath, true) };
+
+	//Next launch maps the cache, a read-only resource folder just means parsing every time
+	if (WriteFileAtomically(cachePath, container))
+	{
+		pCache = std::make_shared<const MappedFile>(cachePath);
+		if (pCache->IsOpen() && IsValidContainer(pCache->GetData(), pCache->GetSize(), expected))
+			return CreateMesh(std::move(pCache), {});
+	}
+	return CreateMesh(nullptr, std::move(container));
+}
+
+std::shared_ptr<const MeshData> MeshCache::BuildMesh(const std::string& name, std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, bool orderForOverdraw, bool buildStrips)
+{
+	MeshSimplifier::Level mesh{ std::move(vertices), std::move(indices) };
+	const CacheHeader header{ CreateHeader(0, false, orderForOverdraw, buildStrips) };
+	return CreateMesh(nullptr, ProcessMesh(std::move(mesh), header, name, false));
+}
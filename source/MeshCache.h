@@ -0,0 +1,25 @@
+#pragma once
+
+//Standard includes
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	struct MeshData;
+	struct Vertex;
+
+	namespace MeshCache
+	{
+		//Loads an OBJ through its binary cache (<objPath>.meshcache). A cache that matches the OBJ's contents and the options is mapped
+		//and its packed vertices and indices are used in place. Otherwise the OBJ is parsed, reordered for the vertex cache, its levels
+		//of detail built, everything packed and the cache (re)written. orderForOverdraw also draws the outward facing parts of every
+		//level first, buildStrips joins the triangles of every level into strips separated by PrimitiveRestartIndex.
+		//Returns nullptr when neither could be read.
+		std::shared_ptr<const MeshData> LoadMesh(const std::string& objPath, bool flipAxisAndWinding = true, bool orderForOverdraw = true, bool buildStrips = true);
+
+		//Same processing for a generated triangle list, without levels of detail and without a cache. name is only printed.
+		std::shared_ptr<const MeshData> BuildMesh(const std::string& name, std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, bool orderForOverdraw = true, bool buildStrips = true);
+	}
+}
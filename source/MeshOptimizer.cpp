@@ -0,0 +1,468 @@
+//Standard includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+//Project includes
+#include "MeshOptimizer.h"
+#include "DataTypes.h"
+
+using namespace dae;
+
+namespace
+{
+	//Forsyth's tuning, the cache modelled while ordering is larger than the one measured so reuse holds for smaller caches as well
+	constexpr int ScoringCacheSize{ 32 };
+	constexpr float CacheDecayPower{ 1.5f };
+	constexpr float LastTriangleScore{ .75f };
+	constexpr float ValenceBoostScale{ 2.f };
+	constexpr uint32_t NoTriangle{ UINT32_MAX };
+
+	//Vertices in the cache score higher, vertices with few triangles left higher still so no triangle gets stranded
+	float VertexScore(int cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.f;
+
+		float score{};
+		if (cachePosition >= 0)
+		{
+			//The last triangle's vertices get a fixed score, drawing straight from them again mostly makes strips
+			if (cachePosition < 3)
+				score = LastTriangleScore;
+			else
+				score = std::pow(1.f - static_cast<float>(cachePosition - 3) / (ScoringCacheSize - 3), CacheDecayPower);
+		}
+		return score + ValenceBoostScale / std::sqrt(static_cast<float>(remainingTriangles));
+	}
+
+	//FIFO cache simulation, a vertex is cached while fewer than cacheSize misses happened since its own.
+	//Bumping time by cacheSize + 1 flushes the cache.
+	struct CacheSimulation
+	{
+		std::vector<uint32_t> timestamps{};
+		uint32_t time{};
+		uint32_t cacheSize{};
+
+		CacheSimulation(size_t vertexCount, int size) :
+			timestamps(vertexCount),
+			time{ static_cast<uint32_t>(size) + 1 },
+			cacheSize{ static_cast<uint32_t>(size) }
+		{
+		}
+
+		void Flush() { time += cacheSize + 1; }
+
+		int Access(const uint32_t* pTriangle)
+		{
+			int misses{};
+			for (int corner{}; corner < 3; ++corner)
+			{
+				if (time - timestamps[pTriangle[corner]] > cacheSize)
+				{
+					timestamps[pTriangle[corner]] = time++;
+					++misses;
+				}
+			}
+			return misses;
+		}
+	};
+}
+
+void MeshOptimizer::WeldVertices(std::vector<Vertex>& vertices, std::span<uint32_t> indices)
+{
+	struct WeldKey { float values[11]; };
+	std::vector<WeldKey> keys(vertices.size());
+	for (size_t i{}; i < vertices.size(); ++i)
+	{
+		const Vertex& vertex{ vertices[i] };
+		keys[i] = { vertex.position.x, vertex.position.y, vertex.position.z, vertex.color.r, vertex.color.g, vertex.color.b,
+			vertex.uv.x, vertex.uv.y, vertex.normal.x, vertex.normal.y, vertex.normal.z };
+	}
+
+	//Equal keys (bitwise) end up next to each other and share the first one's vertex
+	std::vector<uint32_t> order(vertices.size());
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return memcmp(&keys[a], &keys[b], sizeof(WeldKey)) < 0; });
+
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<Vertex> weldedVertices{};
+	std::vector<uint32_t> cornerCounts{};
+	for (size_t i{}; i < order.size(); ++i)
+	{
+		if (i == 0 || memcmp(&keys[order[i]], &keys[order[i - 1]], sizeof(WeldKey)) != 0)
+		{
+			weldedVertices.push_back(vertices[order[i]]);
+			cornerCounts.push_back(1);
+		}
+		else
+		{
+			weldedVertices.back().tangent += vertices[order[i]].tangent;
+			++cornerCounts.back();
+		}
+		remap[order[i]] = static_cast<uint32_t>(weldedVertices.size() - 1);
+	}
+
+	//A vertex that stayed on its own keeps its tangent exactly
+	for (size_t v{}; v < weldedVertices.size(); ++v)
+	{
+		if (cornerCounts[v] > 1)
+			weldedVertices[v].tangent = Vector3::Reject(weldedVertices[v].tangent, weldedVertices[v].normal).Normalized();
+	}
+
+	for (uint32_t& index : indices)
+		index = remap[index];
+	vertices = std::move(weldedVertices);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0)
+		return;
+
+	//Triangles of every vertex, the first remainingTriangles of each list are the ones not drawn yet
+	std::vector<uint32_t> remainingTriangles(vertexCount);
+	for (size_t i{}; i < triangleCount * 3; ++i)
+		++remainingTriangles[indices[i]];
+
+	std::vector<uint32_t> firstTriangle(vertexCount + 1);
+	for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		firstTriangle[vertex + 1] = firstTriangle[vertex] + remainingTriangles[vertex];
+
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i{}; i < triangleCount * 3; ++i)
+			vertexTriangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		vertexScores[vertex] = VertexScore(-1, remainingTriangles[vertex]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> isDrawn(triangleCount);
+	uint32_t bestTriangle{};
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+	{
+		const uint32_t* pTriangle{ &indices[triangle * 3] };
+		triangleScores[triangle] = vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+		if (triangleScores[triangle] > triangleScores[bestTriangle])
+			bestTriangle = static_cast<uint32_t>(triangle);
+	}
+
+	std::vector<uint32_t> orderedIndices{};
+	orderedIndices.reserve(triangleCount * 3);
+	std::vector<uint32_t> cache{};
+	std::vector<uint32_t> nextCache{};
+	size_t nextUndrawn{};
+
+	while (orderedIndices.size() < triangleCount * 3)
+	{
+		//Nothing next to the cache is left, restart at the first triangle not drawn yet
+		if (bestTriangle == NoTriangle)
+		{
+			while (isDrawn[nextUndrawn])
+				++nextUndrawn;
+			bestTriangle = static_cast<uint32_t>(nextUndrawn);
+		}
+
+		const uint32_t triangle[3]{ indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+		orderedIndices.insert(orderedIndices.end(), triangle, triangle + 3);
+		isDrawn[bestTriangle] = true;
+
+		for (const uint32_t vertex : triangle)
+		{
+			uint32_t* pTriangles{ &vertexTriangles[firstTriangle[vertex]] };
+			uint32_t* pLast{ pTriangles + remainingTriangles[vertex] - 1 };
+			std::iter_swap(std::find(pTriangles, pLast, bestTriangle), pLast);
+			--remainingTriangles[vertex];
+		}
+
+		//Most recently used first, what falls off the end is rescored as uncached
+		nextCache.assign(triangle, triangle + 3);
+		for (const uint32_t vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				nextCache.push_back(vertex);
+		}
+		for (size_t position{}; position < nextCache.size(); ++position)
+		{
+			const uint32_t vertex{ nextCache[position] };
+			cachePositions[vertex] = position < ScoringCacheSize ? static_cast<int>(position) : -1;
+			vertexScores[vertex] = VertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+
+		bestTriangle = NoTriangle;
+		float bestScore{ -1.f };
+		for (const uint32_t vertex : nextCache)
+		{
+			const uint32_t* pTriangles{ &vertexTriangles[firstTriangle[vertex]] };
+			for (uint32_t i{}; i < remainingTriangles[vertex]; ++i)
+			{
+				const uint32_t* pTriangle{ &indices[pTriangles[i] * 3] };
+				triangleScores[pTriangles[i]] = vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+				if (triangleScores[pTriangles[i]] > bestScore)
+				{
+					bestScore = triangleScores[pTriangles[i]];
+					bestTriangle = pTriangles[i];
+				}
+			}
+		}
+
+		if (nextCache.size() > ScoringCacheSize)
+			nextCache.resize(ScoringCacheSize);
+		std::swap(cache, nextCache);
+	}
+
+	std::copy(orderedIndices.begin(), orderedIndices.end(), indices.begin());
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0)
+		return;
+
+	//Where the vertex cache order starts over from cold, reordering there costs nothing
+	std::vector<size_t> hardStarts{};
+	{
+		CacheSimulation cache{ vertices.size(), DefaultCacheSize };
+		for (size_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			if (cache.Access(&indices[triangle * 3]) == 3 || triangle == 0)
+				hardStarts.push_back(triangle);
+		}
+		hardStarts.push_back(triangleCount);
+	}
+
+	//Each hard cluster is cut again as soon as its part so far, drawn from a cold cache, is within threshold of its own ACMR
+	std::vector<size_t> clusterStarts{};
+	{
+		CacheSimulation cache{ vertices.size(), DefaultCacheSize };
+		for (size_t hard{}; hard + 1 < hardStarts.size(); ++hard)
+		{
+			const size_t start{ hardStarts[hard] }, end{ hardStarts[hard + 1] };
+
+			cache.Flush();
+			size_t clusterMisses{};
+			for (size_t triangle{ start }; triangle < end; ++triangle)
+				clusterMisses += cache.Access(&indices[triangle * 3]);
+			const float targetAcmr{ threshold * clusterMisses / (end - start) };
+
+			cache.Flush();
+			clusterStarts.push_back(start);
+			size_t misses{}, clusterStart{ start };
+			for (size_t triangle{ start }; triangle + 1 < end; ++triangle)
+			{
+				misses += cache.Access(&indices[triangle * 3]);
+				if (misses <= targetAcmr * (triangle + 1 - clusterStart))
+				{
+					clusterStarts.push_back(triangle + 1);
+					clusterStart = triangle + 1;
+					misses = 0;
+					cache.Flush();
+				}
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+	}
+
+	const auto getNormal = [&](size_t triangle)
+	{
+		const uint32_t* pTriangle{ &indices[triangle * 3] };
+		const Vector3& p0{ vertices[pTriangle[0]].position };
+		return Vector3::Cross(vertices[pTriangle[1]].position - p0, vertices[pTriangle[2]].position - p0);
+	};
+	const auto getCentroid = [&](size_t triangle)
+	{
+		const uint32_t* pTriangle{ &indices[triangle * 3] };
+		return (vertices[pTriangle[0]].position + vertices[pTriangle[1]].position + vertices[pTriangle[2]].position) / 3.f;
+	};
+
+	//Area weighted, the normals' length is twice the triangle's area
+	Vector3 meshCenter{};
+	float meshArea{};
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+	{
+		const float area{ getNormal(triangle).Magnitude() };
+		meshCenter += getCentroid(triangle) * area;
+		meshArea += area;
+	}
+	if (meshArea > 0.f)
+		meshCenter /= meshArea;
+
+	//Winding decides whether the normals point out of the mesh, the sign of its volume tells which one it uses
+	float signedVolume{};
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+		signedVolume += Vector3::Dot(getCentroid(triangle) - meshCenter, getNormal(triangle));
+	const float outward{ signedVolume < 0.f ? -1.f : 1.f };
+
+	struct Cluster
+	{
+		size_t start{};
+		size_t end{};
+		float sortKey{};
+	};
+	std::vector<Cluster> clusters{};
+	clusters.reserve(clusterStarts.size() - 1);
+	for (size_t i{}; i + 1 < clusterStarts.size(); ++i)
+	{
+		Vector3 center{}, normal{};
+		float area{};
+		for (size_t triangle{ clusterStarts[i] }; triangle < clusterStarts[i + 1]; ++triangle)
+		{
+			const Vector3 triangleNormal{ getNormal(triangle) };
+			const float triangleArea{ triangleNormal.Magnitude() };
+			center += getCentroid(triangle) * triangleArea;
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+
+		//How far out the cluster lies along the way it faces, outer clusters first
+		float sortKey{};
+		if (area > 0.f && normal.SqrMagnitude() > 0.f)
+			sortKey = Vector3::Dot(center / area - meshCenter, normal.Normalized()) * outward;
+		clusters.push_back(Cluster{ clusterStarts[i], clusterStarts[i + 1], sortKey });
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> orderedIndices{};
+	orderedIndices.reserve(triangleCount * 3);
+	for (const Cluster& cluster : clusters)
+		orderedIndices.insert(orderedIndices.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+	std::copy(orderedIndices.begin(), orderedIndices.end(), indices.begin());
+}
+
+std::vector<uint32_t> MeshOptimizer::Stripify(std::span<const uint32_t> indices, size_t vertexCount)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+
+	//Directed edges leaving every vertex, with the corner that completes their triangle
+	struct Edge
+	{
+		uint32_t to{};
+		uint32_t third{};
+		uint32_t triangle{};
+	};
+	std::vector<uint32_t> firstEdge(vertexCount + 1);
+	for (size_t i{}; i < triangleCount * 3; ++i)
+		++firstEdge[indices[i] + 1];
+	for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		firstEdge[vertex + 1] += firstEdge[vertex];
+
+	std::vector<Edge> edges(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(firstEdge.begin(), firstEdge.end() - 1);
+		for (size_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			const uint32_t* pTriangle{ &indices[triangle * 3] };
+			for (int corner{}; corner < 3; ++corner)
+				edges[fill[pTriangle[corner]]++] = Edge{ pTriangle[(corner + 1) % 3], pTriangle[(corner + 2) % 3], static_cast<uint32_t>(triangle) };
+		}
+	}
+
+	//Strips are grown on trial first, a triangle belongs to the strip whose stamp it carries. Degenerates draw nothing and are left out.
+	constexpr uint32_t Drawn{ UINT32_MAX };
+	std::vector<uint32_t> stamps(triangleCount);
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+	{
+		const uint32_t* pTriangle{ &indices[triangle * 3] };
+		if (pTriangle[0] == pTriangle[1] || pTriangle[1] == pTriangle[2] || pTriangle[2] == pTriangle[0])
+			stamps[triangle] = Drawn;
+	}
+
+	const auto growStrip = [&](size_t triangle, int rotation, uint32_t stamp, std::vector<uint32_t>& strip)
+	{
+		const uint32_t* pTriangle{ &indices[triangle * 3] };
+		strip.assign({ pTriangle[rotation], pTriangle[(rotation + 1) % 3], pTriangle[(rotation + 2) % 3] });
+		stamps[triangle] = stamp;
+
+		while (true)
+		{
+			//Even triangles of a strip are wound u, w, x and odd ones u, x, w, so the next one holds u->w or w->u
+			const size_t count{ strip.size() };
+			const uint32_t u{ strip[count - 2] }, w{ strip[count - 1] };
+			const bool isEven{ count % 2 == 0 };
+			const uint32_t from{ isEven ? u : w }, to{ isEven ? w : u };
+
+			const auto last{ edges.begin() + firstEdge[from + 1] };
+			const auto next{ std::find_if(edges.begin() + firstEdge[from], last,
+				[&](const Edge& edge) { return edge.to == to && stamps[edge.triangle] != Drawn && stamps[edge.triangle] != stamp; }) };
+			if (next == last)
+				break;
+
+			stamps[next->triangle] = stamp;
+			strip.push_back(next->third);
+		}
+	};
+
+	std::vector<uint32_t> stripIndices{};
+	std::vector<uint32_t> strip{};
+	uint32_t trialStamp{};
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+	{
+		if (stamps[triangle] == Drawn)
+			continue;
+
+		//Any of the three edges can lead, the one giving the longest strip is kept
+		int bestRotation{};
+		size_t bestLength{};
+		for (int rotation{}; rotation < 3; ++rotation)
+		{
+			growStrip(triangle, rotation, ++trialStamp, strip);
+			if (strip.size() > bestLength)
+			{
+				bestLength = strip.size();
+				bestRotation = rotation;
+			}
+		}
+		growStrip(triangle, bestRotation, Drawn, strip);
+
+		if (!stripIndices.empty())
+			stripIndices.push_back(PrimitiveRestartIndex);
+		stripIndices.insert(stripIndices.end(), strip.begin(), strip.end());
+	}
+	return stripIndices;
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices)
+{
+	constexpr uint32_t Unused{ UINT32_MAX };
+	std::vector<uint32_t> remap(vertices.size(), Unused);
+	uint32_t nextVertex{};
+	for (uint32_t& index : indices)
+	{
+		if (index == PrimitiveRestartIndex)
+			continue;
+		if (remap[index] == Unused)
+			remap[index] = nextVertex++;
+		index = remap[index];
+	}
+	for (uint32_t& newIndex : remap)
+	{
+		if (newIndex == Unused)
+			newIndex = nextVertex++;
+	}
+
+	std::vector<Vertex> orderedVertices(vertices.size());
+	for (size_t vertex{}; vertex < vertices.size(); ++vertex)
+		orderedVertices[remap[vertex]] = vertices[vertex];
+	vertices = std::move(orderedVertices);
+}
+
+float MeshOptimizer::ComputeAcmr(std::span<const uint32_t> indices, size_t vertexCount, int cacheSize)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0)
+		return 0.f;
+
+	CacheSimulation cache{ vertexCount, cacheSize };
+	size_t misses{};
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+		misses += cache.Access(&indices[triangle * 3]);
+	return static_cast<float>(misses) / triangleCount;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace dae
+{
+	struct Vertex;
+
+	//Load time reordering of indexed triangle lists, the triangles drawn stay the same but their order and the vertex order change
+	namespace MeshOptimizer
+	{
+		//FIFO cache the ACMR is measured with, about what a GPU's post-transform cache holds
+		constexpr int DefaultCacheSize{ 16 };
+
+		//Merges the corners that only differ in their tangent into one vertex with the tangents averaged,
+		//without it every corner is its own vertex and no order can reuse any
+		void WeldVertices(std::vector<Vertex>& vertices, std::span<uint32_t> indices);
+
+		//Orders the triangles so the ones sharing vertices are drawn close together (Forsyth's linear-speed optimizer)
+		void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+
+		//Splits a vertex cache optimized list into clusters whose ACMR stays within threshold of the list's own,
+		//then draws the clusters facing away from the mesh's center first so they occlude the inner ones (Sander et al.)
+		void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices, float threshold = 1.05f);
+
+		//Joins a triangle list into strips that keep its winding, separated by PrimitiveRestartIndex.
+		//Strips are started in the list's order so what the passes above did mostly survives.
+		std::vector<uint32_t> Stripify(std::span<const uint32_t> indices, size_t vertexCount);
+
+		//Renumbers the vertices in the order the triangles (or strips) first use them, vertices no triangle uses move to the end
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<uint32_t> indices);
+
+		//Average cache misses per triangle, between 0.5 (ideal on a large closed mesh) and 3 (no reuse)
+		float ComputeAcmr(std::span<const uint32_t> indices, size_t vertexCount, int cacheSize = DefaultCacheSize);
+	}
+}
@@ -0,0 +1,400 @@
+//Standard includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <queue>
+
+//Project includes
+#include "MeshSimplifier.h"
+#include "DataTypes.h"
+
+using namespace dae;
+
+namespace
+{
+	constexpr uint32_t NoVertex{ UINT32_MAX };
+	//Open edges are held in place harder than the surface, holes would otherwise grow
+	constexpr double BorderWeight{ 4.0 };
+	//No collapse may move the surface further than this part of the mesh's bounding box diagonal
+	constexpr double MaxRelativeError{ .1 };
+
+	//Weighted sum of squared distances to a set of planes
+	struct Quadric
+	{
+		double xx{}, xy{}, xz{}, xw{}, yy{}, yz{}, yw{}, zz{}, zw{}, ww{};
+		double weight{};
+
+		static Quadric FromPlane(const Vector3& normal, const Vector3& point, double weight)
+		{
+			const double a{ normal.x }, b{ normal.y }, c{ normal.z };
+			const double d{ -(a * point.x + b * point.y + c * point.z) };
+			return Quadric{ a * a * weight, a * b * weight, a * c * weight, a * d * weight, b * b * weight, b * c * weight, b * d * weight, c * c * weight, c * d * weight, d * d * weight, weight };
+		}
+
+		Quadric operator+(const Quadric& other) const
+		{
+			return Quadric{ xx + other.xx, xy + other.xy, xz + other.xz, xw + other.xw, yy + other.yy, yz + other.yz, yw + other.yw, zz + other.zz, zw + other.zw, ww + other.ww, weight + other.weight };
+		}
+
+		//Mean squared distance, so the cost reads as a distance no matter how many planes were merged
+		double Evaluate(const Vector3& point) const
+		{
+			if (weight <= 0.0)
+				return 0.0;
+
+			const double x{ point.x }, y{ point.y }, z{ point.z };
+			const double sum{ xx * x * x + 2 * xy * x * y + 2 * xz * x * z + 2 * xw * x
+				+ yy * y * y + 2 * yz * y * z + 2 * yw * y
+				+ zz * z * z + 2 * zw * z + ww };
+			return std::max(sum / weight, 0.0);
+		}
+	};
+
+	//Moving point from onto point to, versions tell whether either changed since the cost was computed
+	struct Candidate
+	{
+		double cost{};
+		uint32_t from{};
+		uint32_t to{};
+		uint32_t fromVersion{};
+		uint32_t toVersion{};
+
+		bool operator>(const Candidate& other) const { return cost > other.cost; }
+	};
+
+	//Gives every distinct key an index, equal keys (bitwise) share it
+	template<typename Key>
+	std::vector<uint32_t> Weld(const std::vector<Key>& keys, uint32_t& uniqueCount)
+	{
+		std::vector<uint32_t> order(keys.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return memcmp(&keys[a], &keys[b], sizeof(Key)) < 0; });
+
+		std::vector<uint32_t> remap(keys.size());
+		uniqueCount = 0;
+		for (size_t i{}; i < order.size(); ++i)
+		{
+			if (i > 0 && memcmp(&keys[order[i]], &keys[order[i - 1]], sizeof(Key)) != 0)
+				++uniqueCount;
+			remap[order[i]] = uniqueCount;
+		}
+		if (!keys.empty())
+			++uniqueCount;
+		return remap;
+	}
+
+	//Half edge collapses on a welded copy of the mesh. Vertices that share a position but not their
+	//attributes (UV seams, hard edges) only move along an edge both sides share, which keeps seams closed.
+	class Simplifier final
+	{
+	public:
+		Simplifier(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+		{
+			//Corners with the same position, uv and normal become one vertex, their tangents are averaged
+			struct AttributeKey { float values[8]; };
+			struct PositionKey { float values[3]; };
+			std::vector<AttributeKey> attributeKeys(vertices.size());
+			for (size_t i{}; i < vertices.size(); ++i)
+			{
+				const Vertex& vertex{ vertices[i] };
+				attributeKeys[i] = { vertex.position.x, vertex.position.y, vertex.position.z, vertex.uv.x, vertex.uv.y, vertex.normal.x, vertex.normal.y, vertex.normal.z };
+			}
+
+			uint32_t vertexCount{};
+			const std::vector<uint32_t> vertexRemap{ Weld(attributeKeys, vertexCount) };
+			m_Vertices.resize(vertexCount);
+			std::vector<Vector3> tangentSums(vertexCount);
+			for (size_t i{}; i < vertices.size(); ++i)
+			{
+				m_Vertices[vertexRemap[i]] = vertices[i];
+				tangentSums[vertexRemap[i]] += vertices[i].tangent;
+			}
+			for (uint32_t v{}; v < vertexCount; ++v)
+				m_Vertices[v].tangent = Vector3::Reject(tangentSums[v], m_Vertices[v].normal).Normalized();
+
+			//Points are what the collapses work on, one per distinct position
+			std::vector<PositionKey> positionKeys(vertexCount);
+			for (uint32_t v{}; v < vertexCount; ++v)
+				positionKeys[v] = { m_Vertices[v].position.x, m_Vertices[v].position.y, m_Vertices[v].position.z };
+
+			uint32_t pointCount{};
+			m_PointOf = Weld(positionKeys, pointCount);
+			m_PointPositions.resize(pointCount);
+			for (uint32_t v{}; v < vertexCount; ++v)
+				m_PointPositions[m_PointOf[v]] = m_Vertices[v].position;
+
+			m_Quadrics.resize(pointCount);
+			m_PointVersions.resize(pointCount);
+			m_IsPointRemoved.resize(pointCount);
+			m_PointTriangles.resize(pointCount);
+
+			Vector3 boundsMin{ m_PointPositions.empty() ? Vector3{} : m_PointPositions.front() };
+			Vector3 boundsMax{ boundsMin };
+			for (const Vector3& position : m_PointPositions)
+			{
+				boundsMin = { std::min(boundsMin.x, position.x), std::min(boundsMin.y, position.y), std::min(boundsMin.z, position.z) };
+				boundsMax = { std::max(boundsMax.x, position.x), std::max(boundsMax.y, position.y), std::max(boundsMax.z, position.z) };
+			}
+			const double maxError{ (boundsMax - boundsMin).Magnitude() * MaxRelativeError };
+			m_CostLimit = maxError * maxError;
+
+			//Triangles that are already degenerate in the source are left out
+			std::vector<std::pair<uint32_t, uint32_t>> edges{};
+			for (size_t i{}; i + 2 < indices.size(); i += 3)
+			{
+				const std::array<uint32_t, 3> triangle{ vertexRemap[indices[i]], vertexRemap[indices[i + 1]], vertexRemap[indices[i + 2]] };
+				const std::array<uint32_t, 3> points{ m_PointOf[triangle[0]], m_PointOf[triangle[1]], m_PointOf[triangle[2]] };
+				if (points[0] == points[1] || points[1] == points[2] || points[2] == points[0])
+					continue;
+
+				const uint32_t triangleIndex{ static_cast<uint32_t>(m_Triangles.size()) };
+				m_Triangles.push_back(triangle);
+				for (int corner{}; corner < 3; ++corner)
+				{
+					m_PointTriangles[points[corner]].push_back(triangleIndex);
+					edges.emplace_back(std::min(points[corner], points[(corner + 1) % 3]), std::max(points[corner], points[(corner + 1) % 3]));
+				}
+
+				const Vector3 normal{ GetNormal(points[0], points[1], points[2]) };
+				if (normal.SqrMagnitude() > 0.f)
+				{
+					//Weighted by area, tiny triangles hardly count
+					const Quadric plane{ Quadric::FromPlane(normal.Normalized(), m_PointPositions[points[0]], normal.Magnitude() * .5) };
+					for (const uint32_t point : points)
+						m_Quadrics[point] = m_Quadrics[point] + plane;
+				}
+			}
+			m_IsTriangleRemoved.resize(m_Triangles.size());
+			m_TriangleCount = m_Triangles.size();
+
+			//Edges used by a single triangle get a plane standing on them
+			std::sort(edges.begin(), edges.end());
+			for (size_t t{}; t < m_Triangles.size(); ++t)
+			{
+				const std::array<uint32_t, 3> points{ GetPoints(uint32_t(t)) };
+				const Vector3 normal{ GetNormal(points[0], points[1], points[2]) };
+				for (int corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a{ points[corner] };
+					const uint32_t b{ points[(corner + 1) % 3] };
+					const std::pair<uint32_t, uint32_t> edge{ std::min(a, b), std::max(a, b) };
+					const auto range{ std::equal_range(edges.begin(), edges.end(), edge) };
+					if (range.second - range.first != 1)
+						continue;
+
+					const Vector3 edgeVector{ m_PointPositions[b] - m_PointPositions[a] };
+					const Vector3 borderNormal{ Vector3::Cross(edgeVector, normal) };
+					if (borderNormal.SqrMagnitude() <= 0.f)
+						continue;
+					const Quadric plane{ Quadric::FromPlane(borderNormal.Normalized(), m_PointPositions[a], edgeVector.SqrMagnitude() * BorderWeight) };
+					m_Quadrics[a] = m_Quadrics[a] + plane;
+					m_Quadrics[b] = m_Quadrics[b] + plane;
+				}
+			}
+
+			for (uint32_t point{}; point < pointCount; ++point)
+				PushEdges(point);
+		}
+
+		size_t GetTriangleCount() const { return m_TriangleCount; }
+
+		void CollapseTo(size_t targetTriangleCount)
+		{
+			while (m_TriangleCount > targetTriangleCount && !m_Candidates.empty())
+			{
+				const Candidate candidate{ m_Candidates.top() };
+				if (candidate.cost > m_CostLimit)
+					return;
+				m_Candidates.pop();
+
+				if (m_IsPointRemoved[candidate.from] || m_IsPointRemoved[candidate.to]
+					|| candidate.fromVersion != m_PointVersions[candidate.from] || candidate.toVersion != m_PointVersions[candidate.to])
+					continue;
+
+				Collapse(candidate);
+			}
+		}
+
+		//The triangles left, with only the vertices they use
+		MeshSimplifier::Level Extract() const
+		{
+			MeshSimplifier::Level level{};
+			level.error = static_cast<float>(std::sqrt(m_MaxCost));
+
+			std::vector<uint32_t> newIndices(m_Vertices.size(), NoVertex);
+			for (size_t t{}; t < m_Triangles.size(); ++t)
+			{
+				if (m_IsTriangleRemoved[t])
+					continue;
+
+				for (const uint32_t vertex : m_Triangles[t])
+				{
+					if (newIndices[vertex] == NoVertex)
+					{
+						newIndices[vertex] = static_cast<uint32_t>(level.vertices.size());
+						level.vertices.push_back(m_Vertices[vertex]);
+					}
+					level.indices.push_back(newIndices[vertex]);
+				}
+			}
+			return level;
+		}
+
+	private:
+		std::vector<Vertex> m_Vertices{};
+		std::vector<uint32_t> m_PointOf{};
+		std::vector<Vector3> m_PointPositions{};
+		std::vector<Quadric> m_Quadrics{};
+		std::vector<uint32_t> m_PointVersions{};
+		std::vector<bool> m_IsPointRemoved{};
+		std::vector<std::vector<uint32_t>> m_PointTriangles{};
+
+		std::vector<std::array<uint32_t, 3>> m_Triangles{};
+		std::vector<bool> m_IsTriangleRemoved{};
+		size_t m_TriangleCount{};
+
+		std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> m_Candidates{};
+		double m_CostLimit{};
+		double m_MaxCost{};
+
+		std::array<uint32_t, 3> GetPoints(uint32_t triangle) const
+		{
+			const std::array<uint32_t, 3>& vertices{ m_Triangles[triangle] };
+			return { m_PointOf[vertices[0]], m_PointOf[vertices[1]], m_PointOf[vertices[2]] };
+		}
+
+		Vector3 GetNormal(uint32_t point0, uint32_t point1, uint32_t point2) const
+		{
+			return Vector3::Cross(m_PointPositions[point1] - m_PointPositions[point0], m_PointPositions[point2] - m_PointPositions[point0]);
+		}
+
+		//Points that share a triangle with point, dead triangles are dropped along the way
+		std::vector<uint32_t> GetNeighbours(uint32_t point)
+		{
+			std::vector<uint32_t>& triangles{ m_PointTriangles[point] };
+			std::erase_if(triangles, [this](uint32_t triangle) { return m_IsTriangleRemoved[triangle]; });
+
+			std::vector<uint32_t> neighbours{};
+			for (const uint32_t triangle : triangles)
+			{
+				for (const uint32_t other : GetPoints(triangle))
+				{
+					if (other != point)
+						neighbours.push_back(other);
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+			return neighbours;
+		}
+
+		void Push(uint32_t from, uint32_t to)
+		{
+			const double cost{ (m_Quadrics[from] + m_Quadrics[to]).Evaluate(m_PointPositions[to]) };
+			m_Candidates.push(Candidate{ cost, from, to, m_PointVersions[from], m_PointVersions[to] });
+		}
+
+		void PushEdges(uint32_t point)
+		{
+			for (const uint32_t neighbour : GetNeighbours(point))
+			{
+				Push(point, neighbour);
+				Push(neighbour, point);
+			}
+		}
+
+		void Collapse(const Candidate& candidate)
+		{
+			const uint32_t from{ candidate.from };
+			const uint32_t to{ candidate.to };
+
+			//Link condition: the points both ends see must be the tips of the triangles on the edge, or the surface pinches
+			const std::vector<uint32_t> fromNeighbours{ GetNeighbours(from) };
+			const std::vector<uint32_t> toNeighbours{ GetNeighbours(to) };
+			std::vector<uint32_t> shared{};
+			std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(), toNeighbours.begin(), toNeighbours.end(), std::back_inserter(shared));
+
+			//Every vertex at from takes over the attributes of the vertex at to across a triangle they share
+			std::vector<std::pair<uint32_t, uint32_t>> vertexRemap{};
+			size_t edgeTriangleCount{};
+			for (const uint32_t triangle : m_PointTriangles[from])
+			{
+				const std::array<uint32_t, 3> points{ GetPoints(triangle) };
+				const auto toCorner{ std::find(points.begin(), points.end(), to) };
+				if (toCorner == points.end())
+					continue;
+
+				++edgeTriangleCount;
+				const uint32_t fromVertex{ m_Triangles[triangle][std::find(points.begin(), points.end(), from) - points.begin()] };
+				const uint32_t toVertex{ m_Triangles[triangle][toCorner - points.begin()] };
+				if (std::none_of(vertexRemap.begin(), vertexRemap.end(), [fromVertex](const auto& remap) { return remap.first == fromVertex; }))
+					vertexRemap.emplace_back(fromVertex, toVertex);
+			}
+			if (edgeTriangleCount == 0 || shared.size() > edgeTriangleCount)
+				return;
+
+			//Every triangle that stays has to keep a vertex to move to and must not flip over
+			for (const uint32_t triangle : m_PointTriangles[from])
+			{
+				std::array<uint32_t, 3> points{ GetPoints(triangle) };
+				if (std::find(points.begin(), points.end(), to) != points.end())
+					continue;
+
+				const size_t fromCorner{ size_t(std::find(points.begin(), points.end(), from) - points.begin()) };
+				const uint32_t fromVertex{ m_Triangles[triangle][fromCorner] };
+				if (std::none_of(vertexRemap.begin(), vertexRemap.end(), [fromVertex](const auto& remap) { return remap.first == fromVertex; }))
+					return;
+
+				const Vector3 oldNormal{ GetNormal(points[0], points[1], points[2]) };
+				points[fromCorner] = to;
+				const Vector3 newNormal{ GetNormal(points[0], points[1], points[2]) };
+				if (Vector3::Dot(oldNormal, newNormal) <= 0.f)
+					return;
+			}
+
+			for (const uint32_t triangle : m_PointTriangles[from])
+			{
+				const std::array<uint32_t, 3> points{ GetPoints(triangle) };
+				if (std::find(points.begin(), points.end(), to) != points.end())
+				{
+					m_IsTriangleRemoved[triangle] = true;
+					--m_TriangleCount;
+					continue;
+				}
+
+				uint32_t& vertex{ m_Triangles[triangle][std::find(points.begin(), points.end(), from) - points.begin()] };
+				vertex = std::find_if(vertexRemap.begin(), vertexRemap.end(), [vertex](const auto& remap) { return remap.first == vertex; })->second;
+				m_PointTriangles[to].push_back(triangle);
+			}
+
+			m_PointTriangles[from].clear();
+			m_IsPointRemoved[from] = true;
+			m_Quadrics[to] = m_Quadrics[to] + m_Quadrics[from];
+			++m_PointVersions[from];
+			++m_PointVersions[to];
+			m_MaxCost = std::max(m_MaxCost, candidate.cost);
+
+			PushEdges(to);
+		}
+	};
+}
+
+std::vector<MeshSimplifier::Level> MeshSimplifier::BuildLods(std::span<const Vertex> vertices, std::span<const uint32_t> indices, int maxLevelCount)
+{
+	Simplifier simplifier{ vertices, indices };
+
+	std::vector<Level> levels{};
+	for (int level{}; level < maxLevelCount; ++level)
+	{
+		const size_t previousCount{ simplifier.GetTriangleCount() };
+		simplifier.CollapseTo(previousCount / 2);
+
+		//A level that is barely smaller isn't worth its memory
+		if (simplifier.GetTriangleCount() == 0 || simplifier.GetTriangleCount() > previousCount * 3 / 4)
+			break;
+		levels.push_back(simplifier.Extract());
+	}
+	return levels;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace dae
+{
+	struct Vertex;
+
+	namespace MeshSimplifier
+	{
+		struct Level
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			//Roughly how far the simplified surface lies from the full mesh, in object space
+			float error{};
+		};
+
+		//Simplified copies of an indexed triangle list, each with about half the triangles of the one before.
+		//Quadric error edge collapses onto existing vertices, so UVs, normals and hard edges stay as they were.
+		//Fewer levels come back when the mesh can't be reduced any further without tearing it.
+		std::vector<Level> BuildLods(std::span<const Vertex> vertices, std::span<const uint32_t> indices, int maxLevelCount = 4);
+	}
+}
@@ -0,0 +1,360 @@
+//Standard includes
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+//Project includes
+#include "ObjParser.h"
+#include "DataTypes.h"
+#include "MappedFile.h"
+
+using namespace dae;
+
+namespace
+{
+	//Smaller files aren't worth a thread per chunk
+	constexpr size_t MinChunkSize{ 256 * 1024 };
+	constexpr int32_t MissingIndex{ INT32_MIN };
+
+	//position, uv, normal
+	struct Corner
+	{
+		int32_t indices[3]{ MissingIndex, MissingIndex, MissingIndex };
+	};
+
+	//What one range of lines contributes. Negative OBJ indices are stored relative to the chunk's own lists
+	//and listed in relativeIndices, the merge shifts them once it knows how much the chunks before hold.
+	struct Chunk
+	{
+		const char* pBegin{};
+		const char* pEnd{};
+
+		std::vector<Vector3> positions{};
+		std::vector<Vector2> uvs{};
+		std::vector<Vector3> normals{};
+		std::vector<Corner> corners{};
+		std::vector<uint32_t> faceSizes{};
+		std::vector<size_t> relativeIndices{}; //Corner * 3 + attribute
+		size_t triangleCount{};
+		bool isValid{ true };
+
+		//Prefix sums, filled in by the merge
+		size_t positionOffset{};
+		size_t uvOffset{};
+		size_t normalOffset{};
+		size_t cornerOffset{};
+		size_t triangleOffset{};
+	};
+
+	//Runs task(0) ... task(count - 1) at the same time, one on the calling thread
+	template<typename Task>
+	void ParallelFor(size_t count, const Task& task)
+	{
+		std::vector<std::thread> threads{};
+		threads.reserve(count);
+		for (size_t i{ 1 }; i < count; ++i)
+			threads.emplace_back(task, i);
+		task(size_t{ 0 });
+
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	bool IsSpace(char character)
+	{
+		return character == ' ' || character == '\t' || character == '\r';
+	}
+
+	const char* SkipSpaces(const char* p, const char* pEnd)
+	{
+		while (p < pEnd && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	//from_chars is locale independent but rejects a leading '+'
+	bool ParseFloat(const char*& p, const char* pEnd, float& value)
+	{
+		p = SkipSpaces(p, pEnd);
+		if (p < pEnd && *p == '+')
+			++p;
+
+		const std::from_chars_result result{ std::from_chars(p, pEnd, value) };
+		p = result.ptr;
+		return result.ec == std::errc{};
+	}
+
+	//1-based OBJ index to a 0-based one, negative indices count back from the end of the list
+	bool ParseIndex(const char*& p, const char* pEnd, size_t listSize, int32_t& index, bool& isRelative)
+	{
+		int32_t value{};
+		const std::from_chars_result result{ std::from_chars(p, pEnd, value) };
+		p = result.ptr;
+		if (result.ec != std::errc{} || value == 0)
+			return false;
+
+		isRelative = value < 0;
+		index = isRelative ? static_cast<int32_t>(listSize) + value : value - 1;
+		return true;
+	}
+
+	bool ParseFace(const char* p, const char* pEnd, Chunk& chunk)
+	{
+		uint32_t cornerCount{};
+		while (true)
+		{
+			p = SkipSpaces(p, pEnd);
+			if (p >= pEnd)
+				break;
+
+			//v, v/vt, v//vn or v/vt/vn
+			const size_t cornerIndex{ chunk.corners.size() };
+			Corner& corner{ chunk.corners.emplace_back() };
+			const size_t listSizes[3]{ chunk.positions.size(), chunk.uvs.size(), chunk.normals.size() };
+			for (size_t attribute{}; attribute < 3; ++attribute)
+			{
+				//The position is required, an empty slot skips the uv
+				if (attribute > 0)
+				{
+					if (p >= pEnd || *p != '/')
+						break;
+					++p;
+					if (attribute == 1 && p < pEnd && *p == '/')
+						continue;
+				}
+
+				bool isRelative{};
+				if (!ParseIndex(p, pEnd, listSizes[attribute], corner.indices[attribute], isRelative))
+					return false;
+				if (isRelative)
+					chunk.relativeIndices.push_back(cornerIndex * 3 + attribute);
+			}
+
+			++cornerCount;
+		}
+
+		if (cornerCount < 3)
+			return false;
+
+		chunk.faceSizes.push_back(cornerCount);
+		chunk.triangleCount += cornerCount - 2;
+		return true;
+	}
+
+	bool ParseLine(const char* p, const char* pEnd, Chunk& chunk)
+	{
+		p = SkipSpaces(p, pEnd);
+		if (pEnd - p < 2)
+			return true;
+
+		if (p[0] == 'v' && IsSpace(p[1]))
+		{
+			Vector3& position{ chunk.positions.emplace_back() };
+			p += 1;
+			return ParseFloat(p, pEnd, position.x) && ParseFloat(p, pEnd, position.y) && ParseFloat(p, pEnd, position.z);
+		}
+		if (p[0] == 'v' && p[1] == 't')
+		{
+			Vector2& uv{ chunk.uvs.emplace_back() };
+			p += 2;
+			if (!ParseFloat(p, pEnd, uv.x) || !ParseFloat(p, pEnd, uv.y))
+				return false;
+			uv.y = 1 - uv.y;
+			return true;
+		}
+		if (p[0] == 'v' && p[1] == 'n')
+		{
+			Vector3& normal{ chunk.normals.emplace_back() };
+			p += 2;
+			return ParseFloat(p, pEnd, normal.x) && ParseFloat(p, pEnd, normal.y) && ParseFloat(p, pEnd, normal.z);
+		}
+		if (p[0] == 'f' && IsSpace(p[1]))
+			return ParseFace(p + 1, pEnd, chunk);
+
+		//Comments, groups, materials, smoothing groups, ...
+		return true;
+	}
+
+	void ParseChunk(Chunk& chunk)
+	{
+		//Roughly what a line of vehicle.obj takes, saves most of the regrowing
+		const size_t expectedLines{ size_t(chunk.pEnd - chunk.pBegin) / 32 };
+		chunk.positions.reserve(expectedLines / 4);
+		chunk.corners.reserve(expectedLines);
+
+		for (const char* p{ chunk.pBegin }; p < chunk.pEnd && chunk.isValid;)
+		{
+			const char* pLineEnd{ static_cast<const char*>(memchr(p, '\n', chunk.pEnd - p)) };
+			if (!pLineEnd)
+				pLineEnd = chunk.pEnd;
+
+			chunk.isValid = ParseLine(p, pLineEnd, chunk);
+			p = pLineEnd + 1;
+		}
+	}
+
+	template<typename T>
+	void Append(std::vector<T>& list, const std::vector<T>& chunkList)
+	{
+		list.insert(list.end(), chunkList.begin(), chunkList.end());
+	}
+}
+
+bool Utils::ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding)
+{
+	const MappedFile file{ filename };
+	if (!file.IsOpen())
+		return false;
+
+	vertices.clear();
+	indices.clear();
+
+	const char* pData{ reinterpret_cast<const char*>(file.GetData()) };
+	const size_t size{ file.GetSize() };
+
+	//Chunks end right after a line break so no line is split
+	const size_t threadCount{ std::max(size_t{ 1 }, size_t{ std::thread::hardware_concurrency() }) };
+	const size_t chunkCount{ std::clamp(size / MinChunkSize, size_t{ 1 }, threadCount) };
+	std::vector<Chunk> chunks(chunkCount);
+	const char* pChunkBegin{ pData };
+	for (size_t i{}; i < chunkCount; ++i)
+	{
+		const char* pChunkEnd{ pData + size };
+		if (i + 1 < chunkCount)
+		{
+			pChunkEnd = std::max(pChunkBegin, pData + size * (i + 1) / chunkCount);
+			const void* pLineBreak{ memchr(pChunkEnd, '\n', pData + size - pChunkEnd) };
+			pChunkEnd = pLineBreak ? static_cast<const char*>(pLineBreak) + 1 : pData + size;
+		}
+
+		chunks[i].pBegin = pChunkBegin;
+		chunks[i].pEnd = pChunkEnd;
+		pChunkBegin = pChunkEnd;
+	}
+
+	ParallelFor(chunkCount, [&chunks](size_t i) { ParseChunk(chunks[i]); });
+
+	//Where every chunk's part starts in the merged lists
+	std::vector<Vector3> positions{};
+	std::vector<Vector2> UVs{};
+	std::vector<Vector3> normals{};
+	size_t cornerCount{};
+	size_t triangleCount{};
+	for (Chunk& chunk : chunks)
+	{
+		if (!chunk.isValid)
+			return false;
+
+		chunk.positionOffset = positions.size();
+		chunk.uvOffset = UVs.size();
+		chunk.normalOffset = normals.size();
+		chunk.cornerOffset = cornerCount;
+		chunk.triangleOffset = triangleCount;
+
+		Append(positions, chunk.positions);
+		Append(UVs, chunk.uvs);
+		Append(normals, chunk.normals);
+		cornerCount += chunk.corners.size();
+		triangleCount += chunk.triangleCount;
+	}
+
+	vertices.resize(cornerCount);
+	indices.resize(triangleCount * 3);
+
+	//Every chunk writes its own range of vertices and its triangles only use those, no locking needed
+	ParallelFor(chunkCount, [&](size_t i)
+		{
+			Chunk& chunk{ chunks[i] };
+			const size_t offsets[3]{ chunk.positionOffset, chunk.uvOffset, chunk.normalOffset };
+			for (const size_t slot : chunk.relativeIndices)
+				chunk.corners[slot / 3].indices[slot % 3] += static_cast<int32_t>(offsets[slot % 3]);
+
+			const auto isInRange = [](int32_t index, size_t listSize) { return index >= 0 && size_t(index) < listSize; };
+			for (size_t c{}; c < chunk.corners.size(); ++c)
+			{
+				const auto [position, uv, normal] { chunk.corners[c].indices };
+				if (!isInRange(position, positions.size())
+					|| (uv != MissingIndex && !isInRange(uv, UVs.size()))
+					|| (normal != MissingIndex && !isInRange(normal, normals.size())))
+				{
+					chunk.isValid = false;
+					return;
+				}
+
+				Vertex& vertex{ vertices[chunk.cornerOffset + c] };
+				vertex.position = positions[position];
+				if (uv != MissingIndex)
+					vertex.uv = UVs[uv];
+				if (normal != MissingIndex)
+					vertex.normal = normals[normal];
+			}
+
+			//Fan every face around its first corner
+			uint32_t* pIndices{ indices.data() + chunk.triangleOffset * 3 };
+			uint32_t firstCorner{ static_cast<uint32_t>(chunk.cornerOffset) };
+			for (const uint32_t faceSize : chunk.faceSizes)
+			{
+				for (uint32_t corner{ 1 }; corner + 1 < faceSize; ++corner)
+				{
+					*pIndices++ = firstCorner;
+					*pIndices++ = firstCorner + (flipAxisAndWinding ? corner + 1 : corner);
+					*pIndices++ = firstCorner + (flipAxisAndWinding ? corner : corner + 1);
+				}
+				firstCorner += faceSize;
+			}
+
+			//Cheap Tangent Calculations
+			const uint32_t* pChunkIndices{ indices.data() + chunk.triangleOffset * 3 };
+			for (size_t t{}; t < chunk.triangleCount; ++t)
+			{
+				const uint32_t index0{ pChunkIndices[t * 3] };
+				const uint32_t index1{ pChunkIndices[t * 3 + 1] };
+				const uint32_t index2{ pChunkIndices[t * 3 + 2] };
+
+				const Vector3& p0 = vertices[index0].position;
+				const Vector3& p1 = vertices[index1].position;
+				const Vector3& p2 = vertices[index2].position;
+				const Vector2& uv0 = vertices[index0].uv;
+				const Vector2& uv1 = vertices[index1].uv;
+				const Vector2& uv2 = vertices[index2].uv;
+
+				const Vector3 edge0 = p1 - p0;
+				const Vector3 edge1 = p2 - p0;
+				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
+				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
+				float r = 1.f / Vector2::Cross(diffX, diffY);
+
+				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
+				vertices[index0].tangent += tangent;
+				vertices[index1].tangent += tangent;
+				vertices[index2].tangent += tangent;
+			}
+
+			//Fix the tangents per vertex now because we accumulated
+			for (size_t v{ chunk.cornerOffset }; v < chunk.cornerOffset + chunk.corners.size(); ++v)
+			{
+				Vertex& vertex{ vertices[v] };
+				vertex.tangent = Vector3::Reject(vertex.tangent, vertex.normal).Normalized();
+
+				if (flipAxisAndWinding)
+				{
+					vertex.position.z *= -1.f;
+					vertex.normal.z *= -1.f;
+					vertex.tangent.z *= -1.f;
+				}
+			}
+		});
+
+	for (const Chunk& chunk : chunks)
+	{
+		if (!chunk.isValid)
+		{
+			vertices.clear();
+			indices.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
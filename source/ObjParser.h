@@ -0,0 +1,19 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	struct Vertex;
+
+	namespace Utils
+	{
+		//Positions, UVs, normals and faces with any number of corners, which are fanned into triangles.
+		//Indices may be negative (relative to the end of the list so far). Every face corner becomes its own vertex.
+		//The file is memory mapped, split into line aligned chunks and the chunks are parsed in parallel.
+		bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true);
+	}
+}
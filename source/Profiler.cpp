@@ -0,0 +1,316 @@
+//Standard includes
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//External includes
+#include "SDL.h"
+
+//Project includes
+#include "Profiler.h"
+
+#if DAE_PROFILING
+using namespace dae;
+
+namespace
+{
+	//Per thread, a frame of the W4 pipeline records about a dozen zones on the render thread
+	constexpr uint64_t RingCapacity{ 1 << 16 };
+
+	struct Zone
+	{
+		const char* pName;
+		uint64_t startTicks;
+		uint64_t endTicks;
+		uint32_t frame;
+	};
+
+	//Ring slot of a Zone. Its fields are atomics so a capture can read a slot while the owner overwrites it without a data race,
+	//sequence tells whether what it read is one whole zone: index + 1 once zone index is written, 0 while it is being written.
+	struct ZoneSlot
+	{
+		std::atomic<uint64_t> sequence{};
+		std::atomic<const char*> pName{};
+		std::atomic<uint64_t> startTicks{};
+		std::atomic<uint64_t> endTicks{};
+		std::atomic<uint32_t> frame{};
+	};
+
+	struct Sum
+	{
+		const char* pName;
+		uint64_t firstTicks;
+		uint64_t ticks;
+	};
+
+	struct ThreadRing
+	{
+		uint32_t id{};
+		std::string name{};
+		std::unique_ptr<ZoneSlot[]> pZones{ std::make_unique<ZoneSlot[]>(RingCapacity) }; //Only read below count
+		//Only the owning thread writes, a capture reads everything below count
+		std::atomic<uint64_t> count{};
+		uint64_t takenCount{}; //Owner only, where TakeThreadZones continues
+		std::vector<Sum> sums{};
+	};
+
+	//Rings outlive their threads so a capture can still read what a finished worker recorded.
+	//A new thread takes over the ring of a finished one, tools that start threads per run don't pile up rings.
+	std::mutex g_RingsMutex{};
+	std::vector<std::unique_ptr<ThreadRing>> g_Rings{};
+	std::vector<ThreadRing*> g_FreeRings{};
+
+	struct RingOwner
+	{
+		ThreadRing* pRing{};
+
+		~RingOwner()
+		{
+			if (!pRing)
+				return;
+			std::lock_guard lock{ g_RingsMutex };
+			g_FreeRings.push_back(pRing);
+		}
+	};
+	thread_local RingOwner t_RingOwner{};
+
+	std::atomic<uint32_t> g_Frame{};
+	uint64_t g_FrameStartTicks{};
+
+	std::mutex g_CaptureMutex{};
+	std::atomic<bool> g_IsCapturing{};
+	std::string g_CapturePath{};
+	uint32_t g_CaptureFirstFrame{};
+	uint32_t g_CaptureEndFrame{};
+
+	ThreadRing& GetRing()
+	{
+		ThreadRing*& pRing{ t_RingOwner.pRing };
+		if (!pRing)
+		{
+			std::lock_guard lock{ g_RingsMutex };
+			if (g_FreeRings.empty())
+			{
+				g_Rings.push_back(std::make_unique<ThreadRing>());
+				pRing = g_Rings.back().get();
+				pRing->id = static_cast<uint32_t>(g_Rings.size());
+			}
+			else
+			{
+				//What the finished thread recorded is dropped, a capture holds this lock while it copies
+				pRing = g_FreeRings.back();
+				g_FreeRings.pop_back();
+				pRing->count.store(0, std::memory_order_release);
+				pRing->takenCount = 0;
+				pRing->sums.clear();
+			}
+			pRing->name = "Thread " + std::to_string(pRing->id);
+		}
+		return *pRing;
+	}
+
+	//Owner only
+	void WriteZone(ZoneSlot& slot, uint64_t index, const Zone& zone)
+	{
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.pName.store(zone.pName, std::memory_order_relaxed);
+		slot.startTicks.store(zone.startTicks, std::memory_order_relaxed);
+		slot.endTicks.store(zone.endTicks, std::memory_order_relaxed);
+		slot.frame.store(zone.frame, std::memory_order_relaxed);
+		slot.sequence.store(index + 1, std::memory_order_release);
+	}
+
+	//False when the owner wrapped around onto the slot before or while it was read
+	bool ReadZone(const ZoneSlot& slot, uint64_t index, Zone& zone)
+	{
+		if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+			return false;
+		zone = Zone{ slot.pName.load(std::memory_order_relaxed), slot.startTicks.load(std::memory_order_relaxed),
+			slot.endTicks.load(std::memory_order_relaxed), slot.frame.load(std::memory_order_relaxed) };
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+	}
+
+	//Copies the zones of ring recorded during [firstFrame, endFrame) that were not overwritten while copying
+	void CopyZones(const ThreadRing& ring, uint32_t firstFrame, uint32_t endFrame, std::vector<Zone>& zones)
+	{
+		const uint64_t count{ ring.count.load(std::memory_order_acquire) };
+		const uint64_t first{ count > RingCapacity ? count - RingCapacity : 0 };
+
+		for (uint64_t i{ first }; i < count; ++i)
+		{
+			Zone zone{};
+			if (ReadZone(ring.pZones[i % RingCapacity], i, zone) && zone.frame >= firstFrame && zone.frame < endFrame)
+				zones.push_back(zone);
+		}
+	}
+
+	void WriteCapture(const std::string& filePath, uint32_t firstFrame, uint32_t endFrame)
+	{
+		std::vector<std::pair<const ThreadRing*, std::vector<Zone>>> threads{};
+		{
+			std::lock_guard lock{ g_RingsMutex };
+			for (const std::unique_ptr<ThreadRing>& pRing : g_Rings)
+			{
+				threads.emplace_back(pRing.get(), std::vector<Zone>{});
+				CopyZones(*pRing, firstFrame, endFrame, threads.back().second);
+			}
+		}
+
+		uint64_t baseTicks{ UINT64_MAX };
+		for (const auto& [pRing, zones] : threads)
+		{
+			for (const Zone& zone : zones)
+				baseTicks = std::min(baseTicks, zone.startTicks);
+		}
+
+		std::ofstream file{ filePath };
+		if (!file)
+		{
+			std::cout << "Could not write profile to " << filePath << std::endl;
+			return;
+		}
+
+		//Timestamps are in microseconds
+		const double microsecondsPerTick{ 1'000'000.0 / static_cast<double>(SDL_GetPerformanceFrequency()) };
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Rasterizer\"}}";
+
+		size_t zoneCount{};
+		for (const auto& [pRing, zones] : threads)
+		{
+			if (zones.empty())
+				continue;
+
+			{
+				std::lock_guard lock{ g_RingsMutex };
+				file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pRing->id << ",\"args\":{\"name\":\"" << pRing->name << "\"}}";
+			}
+			for (const Zone& zone : zones)
+			{
+				file << ",\n{\"name\":\"" << zone.pName << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pRing->id
+					<< ",\"ts\":" << (zone.startTicks - baseTicks) * microsecondsPerTick
+					<< ",\"dur\":" << (zone.endTicks - zone.startTicks) * microsecondsPerTick
+					<< ",\"args\":{\"frame\":" << zone.frame << "}}";
+			}
+			zoneCount += zones.size();
+		}
+		file << "\n]}\n";
+
+		std::cout << "Profile of " << endFrame - firstFrame << " frames (" << zoneCount << " zones) saved to " << filePath << std::endl;
+	}
+}
+
+uint64_t Profiler::GetTicks()
+{
+	return SDL_GetPerformanceCounter();
+}
+
+void Profiler::SetThreadName(const char* pName)
+{
+	ThreadRing& ring{ GetRing() };
+	std::lock_guard lock{ g_RingsMutex };
+	ring.name = pName;
+}
+
+void Profiler::Record(const char* pName, uint64_t startTicks, uint64_t endTicks)
+{
+	ThreadRing& ring{ GetRing() };
+	const uint64_t index{ ring.count.load(std::memory_order_relaxed) };
+	WriteZone(ring.pZones[index % RingCapacity], index, Zone{ pName, startTicks, endTicks, g_Frame.load(std::memory_order_relaxed) });
+	ring.count.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::AddToSum(const char* pName, uint64_t startTicks, uint64_t endTicks)
+{
+	//A handful of sums per thread, compared by pointer
+	std::vector<Sum>& sums{ GetRing().sums };
+	auto it{ std::find_if(sums.begin(), sums.end(), [pName](const Sum& sum) { return sum.pName == pName; }) };
+	if (it == sums.end())
+		it = sums.insert(sums.end(), Sum{ pName, 0, 0 });
+
+	if (it->ticks == 0)
+		it->firstTicks = startTicks;
+	it->ticks += endTicks - startTicks;
+}
+
+void Profiler::FlushSums()
+{
+	for (Sum& sum : GetRing().sums)
+	{
+		if (sum.ticks == 0)
+			continue;
+		Record(sum.pName, sum.firstTicks, sum.firstTicks + sum.ticks);
+		sum.ticks = 0;
+	}
+}
+
+void Profiler::EndFrame()
+{
+	//Frames are back to back on the render thread, the first one starts at its first EndFrame
+	const uint64_t ticks{ GetTicks() };
+	if (g_FrameStartTicks != 0)
+		Record("Frame", g_FrameStartTicks, ticks);
+	g_FrameStartTicks = ticks;
+
+	const uint32_t frame{ g_Frame.fetch_add(1, std::memory_order_relaxed) + 1 };
+	if (!g_IsCapturing.load(std::memory_order_acquire))
+		return;
+
+	std::string filePath{};
+	uint32_t firstFrame{};
+	{
+		std::lock_guard lock{ g_CaptureMutex };
+		if (frame < g_CaptureEndFrame)
+			return;
+		filePath = g_CapturePath;
+		firstFrame = g_CaptureFirstFrame;
+	}
+
+	WriteCapture(filePath, firstFrame, frame);
+	g_IsCapturing.store(false, std::memory_order_release);
+}
+
+void Profiler::RequestCapture(int frameCount, const std::string& filePath)
+{
+	if (frameCount <= 0 || g_IsCapturing.load(std::memory_order_acquire))
+		return;
+
+	{
+		std::lock_guard lock{ g_CaptureMutex };
+		g_CapturePath = filePath;
+		g_CaptureFirstFrame = g_Frame.load(std::memory_order_relaxed);
+		g_CaptureEndFrame = g_CaptureFirstFrame + static_cast<uint32_t>(frameCount);
+	}
+	g_IsCapturing.store(true, std::memory_order_release);
+	std::cout << "Profiling the next " << frameCount << " frames" << std::endl;
+}
+
+bool Profiler::IsCapturing()
+{
+	return g_IsCapturing.load(std::memory_order_acquire);
+}
+
+void Profiler::TakeThreadZones(std::vector<ZoneTiming>& zones)
+{
+	ThreadRing& ring{ GetRing() };
+	const uint64_t count{ ring.count.load(std::memory_order_relaxed) };
+	const double secondsPerTick{ 1.0 / static_cast<double>(SDL_GetPerformanceFrequency()) };
+
+	zones.clear();
+	for (uint64_t i{ std::max(ring.takenCount, count > RingCapacity ? count - RingCapacity : 0) }; i < count; ++i)
+	{
+		Zone zone{};
+		ReadZone(ring.pZones[i % RingCapacity], i, zone); //The owner's own zones are never torn
+		zones.push_back(ZoneTiming{ zone.pName, (zone.endTicks - zone.startTicks) * secondsPerTick });
+	}
+	ring.takenCount = count;
+}
+#endif
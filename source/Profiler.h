@@ -0,0 +1,119 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Zones are on unless the build defines DAE_PROFILING=0, then every PROFILE_ macro expands to nothing.
+//The Debug and Release configurations define it, Profile is Release with zones.
+#ifndef DAE_PROFILING
+#define DAE_PROFILING 1
+#endif
+
+namespace dae
+{
+#if DAE_PROFILING
+	//Every thread records its zones into its own ring buffer, only a capture reads them.
+	//Recording a zone is two reads of SDL's performance counter and a handful of plain stores into its ring slot.
+	namespace Profiler
+	{
+		struct ZoneTiming
+		{
+			const char* pName;
+			double seconds;
+		};
+
+		uint64_t GetTicks();
+
+		//Shown as the track's name in the trace, threads without one are numbered
+		void SetThreadName(const char* pName);
+
+		//pName has to outlive the capture, string literals do
+		void Record(const char* pName, uint64_t startTicks, uint64_t endTicks);
+
+		//For zones that run thousands of times a frame (e.g. one per shading batch). Their time is summed per thread
+		//and FlushSums records each sum as a single zone that starts at the first tick that went into it.
+		void AddToSum(const char* pName, uint64_t startTicks, uint64_t endTicks);
+		void FlushSums();
+
+		//Called once per frame by the thread that renders, writes a pending capture once its last frame has ended
+		void EndFrame();
+
+		//Writes the zones of every thread during the next frameCount frames to filePath as Chrome trace JSON,
+		//open it in chrome://tracing or ui.perfetto.dev. Ignored while another capture runs.
+		void RequestCapture(int frameCount, const std::string& filePath);
+		bool IsCapturing();
+
+		//The zones the calling thread recorded since it last called this, oldest first, for tools that time their own frames.
+		//Sums show up once they are flushed, zones the ring dropped in between are lost.
+		void TakeThreadZones(std::vector<ZoneTiming>& zones);
+	}
+
+	class ProfileZone final
+	{
+	public:
+		explicit ProfileZone(const char* pName) :
+			m_pName{ pName },
+			m_StartTicks{ Profiler::GetTicks() }
+		{
+		}
+
+		~ProfileZone()
+		{
+			Profiler::Record(m_pName, m_StartTicks, Profiler::GetTicks());
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone(ProfileZone&&) noexcept = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+		ProfileZone& operator=(ProfileZone&&) noexcept = delete;
+
+	private:
+		const char* m_pName;
+		uint64_t m_StartTicks;
+	};
+
+	class ProfileSumZone final
+	{
+	public:
+		explicit ProfileSumZone(const char* pName) :
+			m_pName{ pName },
+			m_StartTicks{ Profiler::GetTicks() }
+		{
+		}
+
+		~ProfileSumZone()
+		{
+			Profiler::AddToSum(m_pName, m_StartTicks, Profiler::GetTicks());
+		}
+
+		ProfileSumZone(const ProfileSumZone&) = delete;
+		ProfileSumZone(ProfileSumZone&&) noexcept = delete;
+		ProfileSumZone& operator=(const ProfileSumZone&) = delete;
+		ProfileSumZone& operator=(ProfileSumZone&&) noexcept = delete;
+
+	private:
+		const char* m_pName;
+		uint64_t m_StartTicks;
+	};
+#endif
+}
+
+#if DAE_PROFILING
+#define DAE_PROFILE_CONCAT_INNER(a, b) a##b
+#define DAE_PROFILE_CONCAT(a, b) DAE_PROFILE_CONCAT_INNER(a, b)
+
+//Times the rest of the enclosing scope
+#define PROFILE_ZONE(name) const dae::ProfileZone DAE_PROFILE_CONCAT(profileZone, __LINE__){ name }
+#define PROFILE_SUM_ZONE(name) const dae::ProfileSumZone DAE_PROFILE_CONCAT(profileSumZone, __LINE__){ name }
+#define PROFILE_FLUSH_SUMS() dae::Profiler::FlushSums()
+#define PROFILE_THREAD_NAME(name) dae::Profiler::SetThreadName(name)
+#define PROFILE_END_FRAME() dae::Profiler::EndFrame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_SUM_ZONE(name)
+#define PROFILE_FLUSH_SUMS()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_END_FRAME()
+#endif
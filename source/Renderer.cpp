@@ -1,98 +1,262 @@
 //External includes
 #include "SDL.h"
 #include "SDL_surface.h"
+#include <bit>
 #include <iostream>
 
 //Project includes
 #include "Renderer.h"
+#include "DynamicResolution.h"
+#include "FramePresenter.h"
+#include "Scene.h"
 #include "Math.h"
 #include "Matrix.h"
+#include "Memory.h"
+#include "Profiler.h"
+#include "SIMDHelpers.h"
 #include "Texture.h"
 #include "Utils.h"
+#include "VertexPacking.h"
 
 using namespace dae;
 
-Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow)
+namespace
+{
+	//Lighting shared by the scalar and the batched PixelShading
+	const Vector3 g_LightDirection{ .577f, -.577f, .577f };
+	constexpr float g_LightIntensity{ 7.f };
+	constexpr float g_Shininess{ 25.f };
+	const ColorRGB g_Ambient{ .025f, .025f, .025f };
+
+	//Fill using non-temporal stores, for bulk clears that won't be read back soon
+	void StreamFill(uint32_t* pPixels, size_t count, uint32_t value)
+	{
+#if defined(__AVX2__)
+		size_t i{};
+		for (; i < count && (reinterpret_cast<uintptr_t>(pPixels + i) & 31) != 0; ++i)
+			pPixels[i] = value;
+
+		const __m256i wideValue{ _mm256_set1_epi32(value) };
+		for (; i + 8 <= count; i += 8)
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(pPixels + i), wideValue);
+
+		for (; i < count; ++i)
+			pPixels[i] = value;
+#else
+		std::fill_n(pPixels, count, value);
+#endif
+	}
+
+	void StreamFill(float* pPixels, size_t count, float value)
+	{
+#if defined(__AVX2__)
+		size_t i{};
+		for (; i < count && (reinterpret_cast<uintptr_t>(pPixels + i) & 31) != 0; ++i)
+			pPixels[i] = value;
+
+		const __m256 wideValue{ _mm256_set1_ps(value) };
+		for (; i + 8 <= count; i += 8)
+			_mm256_stream_ps(pPixels + i, wideValue);
+
+		for (; i < count; ++i)
+			pPixels[i] = value;
+#else
+		std::fill_n(pPixels, count, value);
+#endif
+	}
+
+	//1 blue, 2 cyan, 3 green, 4 yellow, 6 red and white from 8 on
+	ColorRGB GetHeatColor(int count)
+	{
+		static const ColorRGB ramp[]{ { 0.f, 0.f, 1.f }, { 0.f, 1.f, 1.f }, { 0.f, 1.f, 0.f }, { 1.f, 1.f, 0.f }, { 1.f, .5f, 0.f }, { 1.f, 0.f, 0.f }, { 1.f, .5f, .5f }, { 1.f, 1.f, 1.f } };
+		return ramp[std::min(count, 8) - 1];
+	}
+
+	//Turns a mesh's indices into triangles, one step of the loop at a time. A list has one triangle per step, a strip one
+	//per index: restarts and degenerate triangles are skipped and every other triangle swaps its last two indices so the
+	//whole strip keeps the winding of its first triangle.
+	struct TriangleAssembler
+	{
+		IndexView indices{};
+		PrimitiveTopology topology{};
+		size_t stripStart{};
+
+		size_t GetStepCount() const
+		{
+			//Empty and placeholder meshes hold no triangle, and size() - 2 would wrap for a strip
+			if (indices.size() < 3)
+				return 0;
+			return (topology == PrimitiveTopology::TriangleList) ? indices.size() / 3 : indices.size() - 2;
+		}
+
+		//False when step i has no triangle, a restart moves i past itself so the loop continues with the next strip
+		bool Assemble(size_t& i, uint32_t (&triangle)[3])
+		{
+			if (topology == PrimitiveTopology::TriangleList)
+			{
+				triangle[0] = indices[i * 3];
+				triangle[1] = indices[i * 3 + 1];
+				triangle[2] = indices[i * 3 + 2];
+				return true;
+			}
+
+			//Restart index, the next strip starts right after it with its own winding
+			if (indices[i + 2] == PrimitiveRestartIndex)
+			{
+				stripStart = i + 3;
+				i += 2;
+				return false;
+			}
+			if (indices[i] == PrimitiveRestartIndex || indices[i + 1] == PrimitiveRestartIndex)
+			{
+				//Only after a strip shorter than one triangle
+				if (indices[i] == PrimitiveRestartIndex)
+					stripStart = i + 1;
+				return false;
+			}
+			if (indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2])
+				return false; // new strip, skip;
+
+			//Clockwise, the odd triangles of a strip are counter clockwise
+			const bool isFlipped{ (i - stripStart) % 2 != 0 };
+			triangle[0] = indices[i];
+			triangle[1] = indices[isFlipped ? i + 2 : i + 1];
+			triangle[2] = indices[isFlipped ? i + 1 : i + 2];
+			return true;
+		}
+	};
+
+	//Streaming stores are weakly ordered, they have to land before anyone reads the buffer
+	void StreamFence()
+	{
+#if defined(__AVX2__)
+		_mm_sfence();
+#endif
+	}
+}
+
+Renderer::Renderer(SDL_Window* pWindow, int frameQueueDepth, std::shared_ptr<const Scene> pScene) :
+	m_pWindow(pWindow),
+	m_pScene(std::move(pScene))
 {
 	//Initialize
 	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 
 	//Create Buffers
 	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+	CreateBuffers(std::max(frameQueueDepth, 1));
+
+	std::vector<SDL_Surface*> targetSurfaces{};
+	for (const ColorTarget& target : m_ColorTargets)
+		targetSurfaces.push_back(target.pSurface);
+	m_pPresenter = new FramePresenter{ pWindow, targetSurfaces };
+
+	Initialize();
+}
+
+Renderer::Renderer(int width, int height, std::shared_ptr<const Scene> pScene) :
+	m_Width(width),
+	m_Height(height),
+	m_pScene(std::move(pScene))
+{
+	//Nothing to present to, a single target is enough
+	CreateBuffers(1);
+	Initialize();
+}
+
+Renderer::Renderer(int width, int height, const std::vector<uint32_t*>& targetPixels, std::shared_ptr<const Scene> pScene) :
+	m_Width(width),
+	m_Height(height),
+	m_pScene(std::move(pScene))
+{
+	CreateBuffers(static_cast<int>(targetPixels.size()), targetPixels.data());
+	Initialize();
+}
+
+void Renderer::CreateBuffers(int colorTargetCount, uint32_t* const* pExternalPixels)
+{
+	m_RenderWidth = m_FrameWidth = m_Width;
+	m_RenderHeight = m_FrameHeight = m_Height;
+	m_TilesX = (m_Width + TileSize - 1) / TileSize;
+	m_TilesY = (m_Height + TileSize - 1) / TileSize;
+	m_DepthTiles.resize(size_t(m_TilesX) * m_TilesY);
+
+	//Same XRGB8888 layout SDL_CreateRGBSurface picks for 32 bits without masks
+	m_ColorTargets.resize(colorTargetCount);
+	for (int i{}; i < colorTargetCount; ++i)
+	{
+		ColorTarget& target{ m_ColorTargets[i] };
+		target.isExternal = pExternalPixels != nullptr;
+		target.pPixels = target.isExternal ? pExternalPixels[i] : Memory::AllocatePages<uint32_t>(size_t(m_Width) * m_Height);
+		target.pSurface = SDL_CreateRGBSurfaceFrom(target.pPixels, m_Width, m_Height, 32, m_Width * 4, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+		target.tiles.resize(size_t(m_TilesX) * m_TilesY);
+	}
+
+	m_pColorTarget = &m_ColorTargets[0];
+	m_pBackBuffer = m_pColorTarget->pSurface;
 	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
 
-	m_pDepthBufferPixels = new float[m_Width * m_Height];
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	assert(m_pBackBuffer->format->BytesPerPixel == 4);
+	m_RedShift = m_pBackBuffer->format->Rshift;
+	m_GreenShift = m_pBackBuffer->format->Gshift;
+	m_BlueShift = m_pBackBuffer->format->Bshift;
+	m_AlphaMask = m_pBackBuffer->format->Amask;
+
+	m_pDepthBufferPixels = Memory::AllocatePages<float>(size_t(m_Width) * m_Height);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
+}
 
+void Renderer::Initialize()
+{
 	//Initialize Camera
 	m_Camera.Initialize(45.f, { .0f, .0f, 0.f }, m_Width / static_cast<float>(m_Height));
+	m_ShadingFocus = { m_Width * .5f, m_Height * .5f };
 
-	//m_pTexture = Texture::LoadFromFile("Resources/uv_grid_2.png");
-	m_pTexture = Texture::LoadFromFile("Resources/tuktuk.png");
-	
-	m_pDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png");
-	m_pGlossTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png");
-	m_pNormalTexture = Texture::LoadFromFile("Resources/vehicle_normal.png");
-	m_pSpecularTexture = Texture::LoadFromFile("Resources/vehicle_specular.png");
-	
-	
-	
-	m_Meshes = {
-		Mesh
-		{
-			/*{
-				Vertex{{-3, 3, -2}, {1, 0, 0}, {0, 0}},
-				Vertex{{0, 3, -2}, {1, 0, 0}, {.5f, 0}},
-				Vertex{{3, 3, -2}, {1, 0, 0}, {1, 0}},
-				Vertex{{-3, 0, -2}, {0, 1, 0}, {0, .5f}},
-				Vertex{{0, 0, -2}, {0, 1, 0}, {.5f, .5f}},
-				Vertex{{3, 0, -2}, {0, 1, 0}, {1, .5f}},
-				Vertex{{-3, -3, -2}, {0, 0, 1}, {0, 1}},
-				Vertex{{0, -3, -2}, {0, 0, 1}, {.5f, 1}},
-				Vertex{{3, -3, -2}, {0, 0, 1}, {1, 1}}
-			},
-			{
-				3,0,4,1,5,2,
-				2,6,
-				6,3,7,4,8,5
-			},
-			PrimitiveTopology::TriangleStrip*/
-		}
-	};
-	
-	//if (!Utils::ParseOBJ("Resources/tuktuk.obj", m_Meshes[0].vertices, m_Meshes[0].indices))
-	//{
-	//	// Failed texture load;
-	//}
-	//m_Meshes[0].primitiveTopology = PrimitiveTopology::TriangleList;
-	//m_Meshes[0].worldMatrix = Matrix::CreateTranslation(Vector3{0, -5, 20});
+	//Assets are loaded once per Scene, meshes are copied but keep pointing at the shared geometry
+	if (!m_pScene)
+		m_pScene = std::make_shared<const Scene>();
 
+	//A window shows placeholders while the scene loads, offscreen frames are saved so they have to be complete
+	if (IsHeadless())
+		m_pScene->WaitUntilLoaded();
 
-	if (!Utils::ParseOBJ("Resources/vehicle.obj", m_Meshes[0].vertices, m_Meshes[0].indices))
-	{
-		// Failed texture load;
-	}
-	m_Meshes[0].primitiveTopology = PrimitiveTopology::TriangleList;
-	m_Meshes[0].worldMatrix = Matrix::CreateTranslation(Vector3{ 0, 0, 50 });
+	m_Meshes = m_pScene->GetMeshes();
+	UpdateAssets();
 
-	PrintInstructions();
+	if (!IsHeadless())
+		PrintInstructions();
 }
 
 Renderer::~Renderer()
 {
-	delete[] m_pDepthBufferPixels;
-	delete m_pTexture;
-	delete m_pDiffuseTexture;
-	delete m_pGlossTexture;
-	delete m_pNormalTexture;
-	delete m_pSpecularTexture;
+	delete m_pPresenter;
+	delete m_pDynamicResolution;
+	for (ColorTarget& target : m_ColorTargets)
+	{
+		SDL_FreeSurface(target.pSurface);
+		if (!target.isExternal)
+			Memory::FreePages(target.pPixels);
+	}
+
+	Memory::FreePages(m_pDepthBufferPixels);
+	Memory::FreePages(m_pTaggedDepthPixels);
+	SetSampleCount(1);
 }
 
 void Renderer::Update(Timer* pTimer)
 {
 	m_Camera.Update(pTimer);
+
+	if (m_pDynamicResolution && m_pDynamicResolution->Update(pTimer->GetElapsed()))
+	{
+		//Same aspect ratio as the window, the camera stays as it is
+		const float scale{ m_pDynamicResolution->GetScale() };
+		m_RenderWidth = std::clamp(static_cast<int>(m_Width * scale + .5f), 1, m_Width);
+		m_RenderHeight = std::clamp(static_cast<int>(m_Height * scale + .5f), 1, m_Height);
+		m_FrameWidth = m_RenderWidth;
+		m_FrameHeight = m_RenderHeight;
+	}
+
 	if (m_RotateMeshes)
 	{
 		for (Mesh& mesh : m_Meshes)
@@ -102,32 +266,72 @@ void Renderer::Update(Timer* pTimer)
 	}
 }
 
+void Renderer::UpdateAssets()
+{
+	if (m_HasLoadedAssets)
+		return;
+
+	//Checked first so nothing that finishes in between is left with its placeholder
+	m_HasLoadedAssets = m_pScene->IsLoaded();
+
+	m_pTexture = m_pScene->GetTexture();
+	m_pDiffuseTexture = m_pScene->GetDiffuseTexture();
+	m_pGlossTexture = m_pScene->GetGlossTexture();
+	m_pNormalTexture = m_pScene->GetNormalTexture();
+	m_pSpecularTexture = m_pScene->GetSpecularTexture();
+
+	for (size_t i{}; i < m_Meshes.size(); ++i)
+	{
+		if (!m_Meshes[i].pSharedData)
+			m_Meshes[i].pSharedData = m_pScene->GetMeshData(i);
+	}
+}
+
 void Renderer::Render()
 {
 	//@START
+	PROFILE_ZONE("Render");
+	UpdateAssets();
+
+	//Wait for a color target that is not being presented
+	int targetIndex{ m_HeadlessTarget };
+	if (m_pPresenter)
+	{
+		//Window updates have to happen on this thread, show what the present thread blitted since last frame
+		m_pPresenter->UpdateWindow();
+		PROFILE_ZONE("AcquireTarget");
+		targetIndex = m_pPresenter->AcquireTarget();
+	}
+	m_pColorTarget = &m_ColorTargets[targetIndex];
+	m_pBackBuffer = m_pColorTarget->pSurface;
+	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+
 	//Lock BackBuffer
 	SDL_LockSurface(m_pBackBuffer);
 
 	//RENDER LOGIC
-	//Render_W1_Part1(); //Rasterizer Stage Only
-	//Render_W1_Part2(); //Projection Stage (Camera)
-	//Render_W1_Part3(); //Barycentric Coordinates
-	//Render_W1_Part4(); //Depth Buffer
-	//Render_W1_Part5(); //BoundingBox Optimization
-
-	//Render_W2_Part1(); //TriangleList
-	//Render_W2_Part2(); //TriangleStrip
-	//Render_W2_Part3(); //Texture, Bounding box fix, Improved depth buffer
-	
-	//Render_W3_Part1(); //TUKTUK and rendering modes
+	switch (m_RenderPath)
+	{
+	case RenderPath::W1_Part1: Render_W1_Part1(); break; //Rasterizer Stage Only
+	case RenderPath::W1_Part2: Render_W1_Part2(); break; //Projection Stage (Camera)
+	case RenderPath::W1_Part3: Render_W1_Part3(); break; //Barycentric Coordinates
+	case RenderPath::W1_Part4: Render_W1_Part4(); break; //Depth Buffer
+	case RenderPath::W1_Part5: Render_W1_Part5(); break; //BoundingBox Optimization
 
-	Render_W4_Part1(); //Pixel Shading
+	case RenderPath::W2_Part1: Render_W2_Part1(); break; //TriangleList
+	case RenderPath::W2_Part2: Render_W2_Part2(); break; //TriangleStrip
+	case RenderPath::W2_Part3: Render_W2_Part3(); break; //Texture, Bounding box fix, Improved depth buffer
+
+	case RenderPath::W3_Part1: Render_W3_Part1(); break; //TUKTUK and rendering modes
+
+	case RenderPath::W4_Part1: Render_W4_Part1(); break; //Pixel Shading
+	}
 
 	//@END
-	//Update SDL Surface
+	//Update SDL Surface, the blit runs on the present thread, the window update next frame
 	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+	if (m_pPresenter)
+		m_pPresenter->Present(targetIndex, m_RenderWidth, m_RenderHeight);
 }
 
 void Renderer::VertexTransformationFunction(const std::vector<Vertex>& vertices_in, std::vector<Vertex>& vertices_out) const
@@ -193,11 +397,18 @@ void Renderer::VertexTransformationFunction(std::vector<Mesh>& meshes) const
 {	
 	for (Mesh& mesh : meshes)
 	{
+		mesh.lodLevel = SelectLod(mesh);
 		mesh.vertices_out.clear();
 
 		// We combine world and view matrix and projection into a single worldViewProjectionMatrix
 		Matrix worldViewProjectionMatrix{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
 
+		if (mesh.pSharedData)
+		{
+			TransformPackedVertices(mesh, worldViewProjectionMatrix);
+			continue;
+		}
+
 		for (const Vertex& vertex : mesh.vertices)
 		{
 			Vector4 position{ worldViewProjectionMatrix.TransformPoint({ vertex.position, 1 }) };
@@ -220,12 +431,67 @@ void Renderer::VertexTransformationFunction(std::vector<Mesh>& meshes) const
 	}
 }
 
+void Renderer::TransformPackedVertices(Mesh& mesh, const Matrix& worldViewProjectionMatrix) const
+{
+	const MeshData& data{ *mesh.pSharedData };
+	const std::span<const PackedVertex> vertices{ data.GetVertices(mesh.lodLevel) };
+	const std::span<const ColorRGB> colors{ data.GetColors(mesh.lodLevel) };
+
+	//Quantized positions go through the dequantization first, folded into the matrices
+	const Matrix dequantizeMatrix{ VertexPacking::GetDequantizeMatrix(data.boundsMin, data.boundsMax) };
+	const Matrix positionMatrix{ dequantizeMatrix * worldViewProjectionMatrix };
+	const Matrix worldPositionMatrix{ dequantizeMatrix * mesh.worldMatrix };
+
+	mesh.vertices_out.resize(vertices.size());
+	for (size_t i{}; i < vertices.size(); ++i)
+	{
+		const PackedVertex& vertex{ vertices[i] };
+		const Vector3 position{ float(vertex.position[0]), float(vertex.position[1]), float(vertex.position[2]) };
+
+		Vertex_Out& v_out{ mesh.vertices_out[i] };
+		v_out.position = positionMatrix.TransformPoint({ position, 1 });
+		v_out.position.x /= v_out.position.w;
+		v_out.position.y /= v_out.position.w;
+		v_out.position.z /= v_out.position.w;
+
+		v_out.color = colors.empty() ? colors::White : colors[i];
+		v_out.uv = { VertexPacking::FromHalf(vertex.uv[0]), VertexPacking::FromHalf(vertex.uv[1]) };
+		v_out.normal = mesh.worldMatrix.TransformVector(VertexPacking::DecodeOctahedral(vertex.normal));
+		v_out.tangent = mesh.worldMatrix.TransformVector(VertexPacking::DecodeOctahedral(vertex.tangent));
+		v_out.viewDirection = (m_Camera.origin - worldPositionMatrix.TransformPoint(position)).Normalized();
+	}
+}
+
+int Renderer::SelectLod(const Mesh& mesh) const
+{
+	if (!mesh.pSharedData || m_LodPixelError <= 0.f)
+		return 0;
+
+	//Bounding sphere around the bounds, the world matrix may scale it
+	const MeshData& data{ *mesh.pSharedData };
+	const float scale{ std::max({ mesh.worldMatrix.GetAxisX().Magnitude(), mesh.worldMatrix.GetAxisY().Magnitude(), mesh.worldMatrix.GetAxisZ().Magnitude() }) };
+	const Vector3 center{ mesh.worldMatrix.TransformPoint((data.boundsMin + data.boundsMax) * .5f) };
+	const float radius{ (data.boundsMax - data.boundsMin).Magnitude() * .5f * scale };
+
+	//Nearest the mesh gets to the camera, nothing is simplified with the camera inside the sphere
+	const float distance{ (center - m_Camera.origin).Magnitude() - radius };
+	if (distance <= 0.f)
+		return 0;
+
+	//The frame height covers 2 * fov units at a distance of 1
+	const float pixelsPerUnit{ m_FrameHeight / (2.f * m_Camera.fov * distance) * scale };
+	int level{};
+	while (level + 1 < data.GetLevelCount() && data.lods[level + 1].error * pixelsPerUnit <= m_LodPixelError)
+		++level;
+	return level;
+}
+
 ColorRGB dae::Renderer::PixelShading(const Vertex_Out& v) const
 {
-	const Vector3 lightDirection{ .577f, -.577f, .577f };
-	const float lightIntesity{ 7.f };
-	const float shininess{ 25.f };
-	const ColorRGB ambient{ .025f, .025f, .025f };
+	const Vector3& lightDirection{ g_LightDirection };
+	const float lightIntesity{ g_LightIntensity };
+	const float shininess{ g_Shininess };
+	const ColorRGB& ambient{ g_Ambient };
 
 	
 	Vector3 normal = v.normal;
@@ -280,9 +546,734 @@ ColorRGB dae::Renderer::PixelShading(const Vertex_Out& v) const
 
 }
 
-bool Renderer::SaveBufferToImage() const
+void Renderer::PixelShading(const FragmentBatch& batch, ColorBatch& colors) const
+{
+#if defined(__AVX2__)
+	const __m256 lightX{ _mm256_set1_ps(g_LightDirection.x) };
+	const __m256 lightY{ _mm256_set1_ps(g_LightDirection.y) };
+	const __m256 lightZ{ _mm256_set1_ps(g_LightDirection.z) };
+	const __m256 zero{ _mm256_setzero_ps() };
+	const __m256 one{ _mm256_set1_ps(1.f) };
+
+	const __m256 vertexNormalX{ _mm256_load_ps(batch.normalX) };
+	const __m256 vertexNormalY{ _mm256_load_ps(batch.normalY) };
+	const __m256 vertexNormalZ{ _mm256_load_ps(batch.normalZ) };
+
+	__m256 normalX{ vertexNormalX };
+	__m256 normalY{ vertexNormalY };
+	__m256 normalZ{ vertexNormalZ };
+	if (m_RenderNormalMap)
+	{
+		const __m256 tangentX{ _mm256_load_ps(batch.tangentX) };
+		const __m256 tangentY{ _mm256_load_ps(batch.tangentY) };
+		const __m256 tangentZ{ _mm256_load_ps(batch.tangentZ) };
+
+		__m256 binormalX, binormalY, binormalZ;
+		SIMD::Cross(vertexNormalX, vertexNormalY, vertexNormalZ, tangentX, tangentY, tangentZ, binormalX, binormalY, binormalZ);
+
+		ColorBatch sampledNormal{};
+		m_pNormalTexture->Sample8(batch.u, batch.v, sampledNormal.r, sampledNormal.g, sampledNormal.b);
+		const __m256 mapX{ _mm256_fmsub_ps(_mm256_load_ps(sampledNormal.r), _mm256_set1_ps(2.f), one) };
+		const __m256 mapY{ _mm256_fmsub_ps(_mm256_load_ps(sampledNormal.g), _mm256_set1_ps(2.f), one) };
+		const __m256 mapZ{ _mm256_fmsub_ps(_mm256_load_ps(sampledNormal.b), _mm256_set1_ps(2.f), one) };
+
+		//Tangent space to world space
+		normalX = _mm256_fmadd_ps(mapX, tangentX, _mm256_fmadd_ps(mapY, binormalX, _mm256_mul_ps(mapZ, vertexNormalX)));
+		normalY = _mm256_fmadd_ps(mapX, tangentY, _mm256_fmadd_ps(mapY, binormalY, _mm256_mul_ps(mapZ, vertexNormalY)));
+		normalZ = _mm256_fmadd_ps(mapX, tangentZ, _mm256_fmadd_ps(mapY, binormalZ, _mm256_mul_ps(mapZ, vertexNormalZ)));
+		SIMD::Normalize(normalX, normalY, normalZ);
+	}
+
+	const __m256 observedArea{ _mm256_sub_ps(zero, SIMD::Dot(normalX, normalY, normalZ, lightX, lightY, lightZ)) };
+
+	//Lanes facing away from the light and lanes past the live count stay black
+	const __m256 laneIndex{ _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f) };
+	const __m256 liveMask{ _mm256_and_ps(
+		_mm256_cmp_ps(observedArea, zero, _CMP_GT_OQ),
+		_mm256_cmp_ps(laneIndex, _mm256_set1_ps(float(batch.count)), _CMP_LT_OQ)) };
+
+	ColorBatch diffuseSample{};
+	m_pDiffuseTexture->Sample8(batch.u, batch.v, diffuseSample.r, diffuseSample.g, diffuseSample.b);
+	const __m256 lambert{ _mm256_set1_ps(g_LightIntensity / PI) };
+	const __m256 diffuseR{ _mm256_mul_ps(_mm256_load_ps(diffuseSample.r), lambert) };
+	const __m256 diffuseG{ _mm256_mul_ps(_mm256_load_ps(diffuseSample.g), lambert) };
+	const __m256 diffuseB{ _mm256_mul_ps(_mm256_load_ps(diffuseSample.b), lambert) };
+
+	//Phong uses the interpolated vertex normal, same as the scalar path
+	ColorBatch glossSample{};
+	m_pGlossTexture->Sample8(batch.u, batch.v, glossSample.r, glossSample.g, glossSample.b);
+	const __m256 exponent{ _mm256_mul_ps(_mm256_load_ps(glossSample.r), _mm256_set1_ps(g_Shininess)) };
+
+	const __m256 twoLightDotNormal{ _mm256_mul_ps(_mm256_set1_ps(2.f), SIMD::Dot(lightX, lightY, lightZ, vertexNormalX, vertexNormalY, vertexNormalZ)) };
+	const __m256 reflectX{ _mm256_fnmadd_ps(twoLightDotNormal, vertexNormalX, lightX) };
+	const __m256 reflectY{ _mm256_fnmadd_ps(twoLightDotNormal, vertexNormalY, lightY) };
+	const __m256 reflectZ{ _mm256_fnmadd_ps(twoLightDotNormal, vertexNormalZ, lightZ) };
+	const __m256 cosAngle{ _mm256_max_ps(SIMD::Dot(reflectX, reflectY, reflectZ,
+		_mm256_load_ps(batch.viewDirectionX), _mm256_load_ps(batch.viewDirectionY), _mm256_load_ps(batch.viewDirectionZ)), zero) };
+	const __m256 specularReflection{ SIMD::Pow(cosAngle, exponent) };
+
+	ColorBatch specularSample{};
+	m_pSpecularTexture->Sample8(batch.u, batch.v, specularSample.r, specularSample.g, specularSample.b);
+	const __m256 phongR{ _mm256_mul_ps(specularReflection, _mm256_load_ps(specularSample.r)) };
+	const __m256 phongG{ _mm256_mul_ps(specularReflection, _mm256_load_ps(specularSample.g)) };
+	const __m256 phongB{ _mm256_mul_ps(specularReflection, _mm256_load_ps(specularSample.b)) };
+
+	__m256 r{}, g{}, b{};
+	switch (m_RenderMode)
+	{
+	case dae::ObservedArea:
+		r = g = b = observedArea;
+		break;
+	case dae::Diffuse:
+		r = _mm256_mul_ps(diffuseR, observedArea);
+		g = _mm256_mul_ps(diffuseG, observedArea);
+		b = _mm256_mul_ps(diffuseB, observedArea);
+		break;
+	case dae::Specular:
+		r = _mm256_mul_ps(phongR, observedArea);
+		g = _mm256_mul_ps(phongG, observedArea);
+		b = _mm256_mul_ps(phongB, observedArea);
+		break;
+	case dae::Ambient:
+		r = _mm256_set1_ps(g_Ambient.r);
+		g = _mm256_set1_ps(g_Ambient.g);
+		b = _mm256_set1_ps(g_Ambient.b);
+		break;
+	case dae::Combined:
+		r = _mm256_fmadd_ps(_mm256_add_ps(diffuseR, phongR), observedArea, _mm256_set1_ps(g_Ambient.r));
+		g = _mm256_fmadd_ps(_mm256_add_ps(diffuseG, phongG), observedArea, _mm256_set1_ps(g_Ambient.g));
+		b = _mm256_fmadd_ps(_mm256_add_ps(diffuseB, phongB), observedArea, _mm256_set1_ps(g_Ambient.b));
+		break;
+	default:
+		throw std::runtime_error("How did you get here????");
+		break;
+	}
+
+	_mm256_store_ps(colors.r, _mm256_and_ps(r, liveMask));
+	_mm256_store_ps(colors.g, _mm256_and_ps(g, liveMask));
+	_mm256_store_ps(colors.b, _mm256_and_ps(b, liveMask));
+#else
+	//No AVX2, shade the lanes one by one
+	for (int i{}; i < batch.count; ++i)
+	{
+		Vertex_Out v{};
+		v.normal = { batch.normalX[i], batch.normalY[i], batch.normalZ[i] };
+		v.tangent = { batch.tangentX[i], batch.tangentY[i], batch.tangentZ[i] };
+		v.uv = { batch.u[i], batch.v[i] };
+		v.viewDirection = { batch.viewDirectionX[i], batch.viewDirectionY[i], batch.viewDirectionZ[i] };
+
+		const ColorRGB color{ PixelShading(v) };
+		colors.r[i] = color.r;
+		colors.g[i] = color.g;
+		colors.b[i] = color.b;
+	}
+#endif
+}
+
+void Renderer::FlushFragmentBatch()
+{
+	if (m_FragmentBatch.count == 0)
+		return;
+
+	PROFILE_SUM_ZONE("PixelShading");
+	ColorBatch colors{};
+	PixelShading(m_FragmentBatch, colors);
+
+	uint32_t pixels[FragmentBatch::Size]{};
+	PackColors(colors, pixels);
+
+	//Written in the order the fragments were added, so later fragments still win
+	for (int i{}; i < m_FragmentBatch.count; ++i)
+	{
+		if (m_MultisampledFrame)
+			WriteSamples(pixels[i], m_FragmentBatch.cellX[i], m_FragmentBatch.cellY[i], m_FragmentBatch.coverage[i]);
+		else
+			WriteShadingCell(pixels[i], m_FragmentBatch.cellX[i], m_FragmentBatch.cellY[i], m_FragmentBatch.rate[i], m_FragmentBatch.coverage[i]);
+	}
+	m_FragmentBatch.count = 0;
+}
+
+void Renderer::AddToFragmentBatch(const Vertex_Out& v, int cellX, int cellY, int rate, uint16_t coverage)
+{
+	const int lane{ m_FragmentBatch.count++ };
+	m_FragmentBatch.normalX[lane] = v.normal.x;
+	m_FragmentBatch.normalY[lane] = v.normal.y;
+	m_FragmentBatch.normalZ[lane] = v.normal.z;
+	m_FragmentBatch.tangentX[lane] = v.tangent.x;
+	m_FragmentBatch.tangentY[lane] = v.tangent.y;
+	m_FragmentBatch.tangentZ[lane] = v.tangent.z;
+	m_FragmentBatch.u[lane] = v.uv.x;
+	m_FragmentBatch.v[lane] = v.uv.y;
+	m_FragmentBatch.viewDirectionX[lane] = v.viewDirection.x;
+	m_FragmentBatch.viewDirectionY[lane] = v.viewDirection.y;
+	m_FragmentBatch.viewDirectionZ[lane] = v.viewDirection.z;
+	m_FragmentBatch.cellX[lane] = cellX;
+	m_FragmentBatch.cellY[lane] = cellY;
+	m_FragmentBatch.rate[lane] = rate;
+	m_FragmentBatch.coverage[lane] = coverage;
+
+	if (m_FragmentBatch.count == FragmentBatch::Size)
+		FlushFragmentBatch();
+}
+
+void Renderer::WriteShadingCell(uint32_t pixel, int cellX, int cellY, int rate, uint16_t coverage)
+{
+	for (int y{}; y < rate; ++y)
+	{
+		for (int x{}; x < rate; ++x)
+		{
+			if (coverage & (1 << (y * rate + x)))
+				m_pBackBufferPixels[size_t(cellX + x) + size_t(cellY + y) * m_Width] = pixel;
+		}
+	}
+}
+
+uint32_t Renderer::PackColor(ColorRGB color) const
+{
+	color.MaxToOne();
+
+	//Saturate as well, MaxToOne leaves negative channels alone
+	return static_cast<uint32_t>(Saturate(color.r) * 255) << m_RedShift
+		| static_cast<uint32_t>(Saturate(color.g) * 255) << m_GreenShift
+		| static_cast<uint32_t>(Saturate(color.b) * 255) << m_BlueShift
+		| m_AlphaMask;
+}
+
+void Renderer::PackColors(const ColorBatch& colors, uint32_t* pPixels) const
+{
+#if defined(__AVX2__)
+	__m256 r{ _mm256_load_ps(colors.r) };
+	__m256 g{ _mm256_load_ps(colors.g) };
+	__m256 b{ _mm256_load_ps(colors.b) };
+
+	//MaxToOne
+	const __m256 one{ _mm256_set1_ps(1.f) };
+	const __m256 maxValue{ _mm256_max_ps(r, _mm256_max_ps(g, b)) };
+	const __m256 scale{ _mm256_div_ps(one, _mm256_max_ps(maxValue, one)) };
+
+	//Saturate and convert to 0-255 with the same truncation as the scalar path
+	const __m256 zero{ _mm256_setzero_ps() };
+	const __m256 toByte{ _mm256_set1_ps(255.f) };
+	const auto toChannel = [&](__m256 channel, uint32_t shift)
+	{
+		channel = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(channel, scale), zero), one);
+		const __m256i value{ _mm256_cvttps_epi32(_mm256_mul_ps(channel, toByte)) };
+		return _mm256_sllv_epi32(value, _mm256_set1_epi32(shift));
+	};
+
+	__m256i packed{ _mm256_set1_epi32(m_AlphaMask) };
+	packed = _mm256_or_si256(packed, toChannel(r, m_RedShift));
+	packed = _mm256_or_si256(packed, toChannel(g, m_GreenShift));
+	packed = _mm256_or_si256(packed, toChannel(b, m_BlueShift));
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(pPixels), packed);
+#else
+	for (int i{}; i < FragmentBatch::Size; ++i)
+		pPixels[i] = PackColor(ColorRGB{ colors.r[i], colors.g[i], colors.b[i] });
+#endif
+}
+
+void Renderer::BeginFrame()
+{
+	++m_FrameIndex;
+	m_MsaaSamples.clear();
+
+	if (m_HeatmapMode != HeatmapMode::Off)
+		m_HeatmapCounts.assign(size_t(m_Width) * m_Height, 0);
+	else
+		m_HeatmapCounts = {};
+
+	if (!m_TaggedDepth)
+		return;
+
+	if (!m_pTaggedDepthPixels)
+	{
+		m_pTaggedDepthPixels = Memory::AllocatePages<uint32_t>(size_t(m_Width) * m_Height);
+		m_DepthGeneration = 0;
+	}
+	else
+	{
+		++m_DepthGeneration;
+	}
+
+	//The tag is 8 bits, once every 256 frames it wraps and stale values could win again
+	if (m_DepthGeneration % 256 == 0)
+	{
+		StreamFill(m_pTaggedDepthPixels, size_t(m_Width) * m_Height, UINT32_MAX);
+		StreamFence();
+	}
+}
+
+void Renderer::ClearTiles(int minX, int minY, int maxX, int maxY)
+{
+	for (int tileY{ minY / TileSize }; tileY <= (maxY - 1) / TileSize; ++tileY)
+	{
+		for (int tileX{ minX / TileSize }; tileX <= (maxX - 1) / TileSize; ++tileX)
+		{
+			const int tileIndex{ tileX + tileY * m_TilesX };
+			TileState& colorTile{ m_pColorTarget->tiles[tileIndex] };
+			TileState& depthTile{ m_DepthTiles[tileIndex] };
+			if (colorTile.clearedFrame == m_FrameIndex && depthTile.clearedFrame == m_FrameIndex)
+				continue;
+
+			//Regular stores, the rasterizer is about to work on these pixels
+			const int startX{ tileX * TileSize };
+			const int width{ std::min(TileSize, m_Width - startX) };
+			//With MSAA the resolve overwrites the whole tile and the depth lives in the sample buffer, those always start clean
+			const bool clearColor{ colorTile.clearedFrame != m_FrameIndex && colorTile.isDirty && !m_MultisampledFrame };
+			const bool clearDepth{ depthTile.clearedFrame != m_FrameIndex && depthTile.isDirty && !m_TaggedDepth && !m_MultisampledFrame };
+			const bool clearSamples{ colorTile.clearedFrame != m_FrameIndex && m_MultisampledFrame };
+			for (int y{ tileY * TileSize }; y < std::min((tileY + 1) * TileSize, m_Height); ++y)
+			{
+				if (clearColor)
+					std::fill_n(m_pBackBufferPixels + startX + size_t(y) * m_Width, width, ClearColor);
+				if (clearDepth)
+					std::fill_n(m_pDepthBufferPixels + startX + size_t(y) * m_Width, width, FLT_MAX);
+				if (clearSamples)
+				{
+					std::fill_n(m_pMsaaColors + startX + size_t(y) * m_Width, width, ClearColor);
+					std::fill_n(m_pMsaaBlocks + startX + size_t(y) * m_Width, width, NoSampleBlock);
+					std::fill_n(m_pSampleDepth + (size_t(startX) + size_t(y) * m_Width) * m_SampleCount, size_t(width) * m_SampleCount, FLT_MAX);
+				}
+			}
+
+			colorTile.clearedFrame = depthTile.clearedFrame = m_FrameIndex;
+			colorTile.isDirty = depthTile.isDirty = true;
+		}
+	}
+}
+
+void Renderer::DrawHeatmap()
+{
+	PROFILE_ZONE("Heatmap");
+	for (int py{}; py < m_RenderHeight; ++py)
+	{
+		for (int px{}; px < m_RenderWidth; ++px)
+		{
+			const size_t pixelIndex{ size_t(px) + size_t(py) * m_Width };
+			const uint16_t count{ m_HeatmapCounts[pixelIndex] };
+			m_pBackBufferPixels[pixelIndex] = count == 0 ? ClearColor : PackColor(GetHeatColor(count));
+		}
+	}
+}
+
+void Renderer::ClearUntouchedTiles()
+{
+	//Only color has to be clean for presenting, untouched depth tiles wait for their next first touch.
+	//Tiles outside the render area are not presented, they stay dirty until the resolution grows back over them.
+	const int renderTilesX{ (m_RenderWidth + TileSize - 1) / TileSize };
+	const int renderTilesY{ (m_RenderHeight + TileSize - 1) / TileSize };
+	for (int tileY{}; tileY < renderTilesY; ++tileY)
+	{
+		for (int tileX{}; tileX < renderTilesX; ++tileX)
+		{
+			TileState& tile{ m_pColorTarget->tiles[tileX + tileY * m_TilesX] };
+			if (tile.clearedFrame == m_FrameIndex || !tile.isDirty)
+				continue;
+
+			const int startX{ tileX * TileSize };
+			const int width{ std::min(TileSize, m_Width - startX) };
+			for (int y{ tileY * TileSize }; y < std::min((tileY + 1) * TileSize, m_Height); ++y)
+				StreamFill(m_pBackBufferPixels + startX + size_t(y) * m_Width, width, ClearColor);
+
+			tile.isDirty = false;
+		}
+	}
+
+	StreamFence();
+}
+
+bool Renderer::DepthTest(size_t pixelIndex, float depth)
+{
+	if (m_TaggedDepth)
+	{
+		//Top byte counts down every frame, so values from earlier frames always compare as further away
+		const uint32_t tag{ 255 - (m_DepthGeneration & 255) };
+		const uint32_t encodedDepth{ tag << 24 | static_cast<uint32_t>(Saturate(depth) * 0xFFFFFF) };
+		if (m_pTaggedDepthPixels[pixelIndex] < encodedDepth)
+			return false;
+
+		m_pTaggedDepthPixels[pixelIndex] = encodedDepth;
+		return true;
+	}
+
+	if (m_pDepthBufferPixels[pixelIndex] < depth)
+		return false;
+
+	m_pDepthBufferPixels[pixelIndex] = depth;
+	return true;
+}
+
+Vertex_Out Renderer::InterpolateVertex(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, float w0, float w1, float w2) const
+{
+	const float wInterpolated = 1 / (1 / v0.position.w * w0 + 1 / v1.position.w * w1 + 1 / v2.position.w * w2);
+
+	Vertex_Out interpolatedVertex{};
+	//interpolatedVertex.color = (v0.color / v0.position.w * w0 + v1.color / v1.position.w * w1 + v2.color / v2.position.w * w2) * wInterpolated;
+	interpolatedVertex.normal = ((v0.normal / v0.position.w * w0 + v1.normal / v1.position.w * w1 + v2.normal / v2.position.w * w2) * wInterpolated).Normalized();
+
+	const Vector2 interpolatedXY{ (v0.position.GetXY() / v0.position.w * w0 + v1.position.GetXY() / v1.position.w * w1 + v2.position.GetXY() / v2.position.w * w2) * wInterpolated };
+	const float interpolatedZ{ 1 / (1 / v0.position.z * w0 + 1 / v1.position.z * w1 + 1 / v2.position.z * w2) };
+	interpolatedVertex.position = Vector4{ interpolatedXY.x, interpolatedXY.y, interpolatedZ, wInterpolated };
+
+	interpolatedVertex.tangent = ((v0.tangent / v0.position.w * w0 + v1.tangent / v1.position.w * w1 + v2.tangent / v2.position.w * w2) * wInterpolated).Normalized();
+	interpolatedVertex.uv = (v0.uv / v0.position.w * w0 + v1.uv / v1.position.w * w1 + v2.uv / v2.position.w * w2) * wInterpolated;
+	interpolatedVertex.viewDirection = (v0.viewDirection / v0.position.w * w0 + v1.viewDirection / v1.position.w * w1 + v2.viewDirection / v2.position.w * w2) * wInterpolated;
+
+	return interpolatedVertex;
+}
+
+int Renderer::GetShadingRate(ShadingRate meshRate, int px, int py) const
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	int rate{ static_cast<int>(meshRate) };
+	if (!m_FoveatedShading)
+		return rate;
+
+	// Distance to the focus point, 1 at the screen corner furthest from the center
+	//The focus is in buffer pixels, the distance is measured in the whole frame
+	const Vector2 focus{ m_ShadingFocus.x * m_FrameWidth / m_Width, m_ShadingFocus.y * m_FrameHeight / m_Height };
+	const Vector2 toFocus{ static_cast<float>(px + m_FrameX) - focus.x, static_cast<float>(py + m_FrameY) - focus.y };
+	const float halfDiagonal{ Vector2{ m_FrameWidth * .5f, m_FrameHeight * .5f }.Magnitude() };
+	const float distance{ toFocus.Magnitude() / halfDiagonal };
+
+	if (distance > .7f)
+		rate = std::max(rate, static_cast<int>(ShadingRate::Rate4x4));
+	else if (distance > .35f)
+		rate = std::max(rate, static_cast<int>(ShadingRate::Rate2x2));
+
+	return rate;
+}
+
+void Renderer::SetSampleCount(int sampleCount)
+{
+	if (sampleCount != 4 && sampleCount != 8)
+		sampleCount = 1;
+
+	Memory::FreePages(m_pMsaaColors);
+	Memory::FreePages(m_pMsaaBlocks);
+	Memory::FreePages(m_pSampleDepth);
+	m_pMsaaColors = m_pMsaaBlocks = nullptr;
+	m_pSampleDepth = nullptr;
+	m_MsaaSamples = {};
+
+	m_SampleCount = sampleCount;
+	if (m_SampleCount == 1)
+		return;
+
+	//Standard D3D sample patterns in 1/16 pixel, around the point the non-AA path samples
+	constexpr float pattern4[]{ -2, -6, 6, -2, -6, 2, 2, 6 };
+	constexpr float pattern8[]{ 1, -3, -1, 3, 5, 1, -3, -5, -5, 5, -7, -1, 3, 7, 7, -7 };
+	const float* pPattern{ m_SampleCount == 4 ? pattern4 : pattern8 };
+	for (int i{}; i < 8; ++i)
+	{
+		m_SampleOffsetX[i] = i < m_SampleCount ? pPattern[i * 2] / 16.f : 0.f;
+		m_SampleOffsetY[i] = i < m_SampleCount ? pPattern[i * 2 + 1] / 16.f : 0.f;
+	}
+
+	//Cleared per tile on first touch like the rest
+	const size_t pixelCount{ size_t(m_Width) * m_Height };
+	m_pMsaaColors = Memory::AllocatePages<uint32_t>(pixelCount);
+	m_pMsaaBlocks = Memory::AllocatePages<uint32_t>(pixelCount);
+	m_pSampleDepth = Memory::AllocatePages<float>(pixelCount * m_SampleCount);
+}
+
+void Renderer::SetFrameRect(int frameWidth, int frameHeight, int x, int y)
+{
+	if (!IsHeadless())
+		return;
+
+	m_FrameWidth = frameWidth;
+	m_FrameHeight = frameHeight;
+	m_FrameX = x;
+	m_FrameY = y;
+	m_RenderWidth = std::clamp(frameWidth - x, 0, m_Width);
+	m_RenderHeight = std::clamp(frameHeight - y, 0, m_Height);
+
+	//Aspect ratio of the whole frame, not of the piece in the buffers
+	m_Camera.CalculateProjectionMatrix(m_FrameWidth / static_cast<float>(m_FrameHeight));
+}
+
+void Renderer::SetDynamicResolution(float targetFrameTime, float minScale)
+{
+	//Offscreen frames are read straight from the buffers and have to keep their size
+	delete m_pDynamicResolution;
+	m_pDynamicResolution = nullptr;
+	m_RenderWidth = m_FrameWidth = m_Width;
+	m_RenderHeight = m_FrameHeight = m_Height;
+	m_FrameX = m_FrameY = 0;
+
+	if (targetFrameTime > 0.f && !IsHeadless())
+		m_pDynamicResolution = new DynamicResolution{ targetFrameTime, minScale };
+}
+
+void Renderer::RasterizeMultisampled(const Vertex_Out& vertex0, const Vertex_Out& vertex1, const Vertex_Out& vertex2, int minX, int minY, int maxX, int maxY)
+{
+	const Vector2 v0{ vertex0.position.GetXY() };
+	const Vector2 v1{ vertex1.position.GetXY() };
+	const Vector2 v2{ vertex2.position.GetXY() };
+
+	//Same edge functions as the non-AA path, measured from a vertex on the edge to keep the precision near the edge
+	const Vector2 edge0{ v2 - v1 };
+	const Vector2 edge1{ v0 - v2 };
+	const Vector2 edge2{ v1 - v0 };
+	const auto edgeFunctions = [&](float x, float y, float& w0, float& w1, float& w2)
+		{
+			w0 = edge0.x * (y - v1.y) - edge0.y * (x - v1.x);
+			w1 = edge1.x * (y - v2.y) - edge1.y * (x - v2.x);
+			w2 = edge2.x * (y - v0.y) - edge2.y * (x - v0.x);
+		};
+
+	//They always add up to twice the area, a triangle without positive area never covers anything
+	const float total{ Vector2::Cross(edge2, v2 - v0) };
+	if (total <= 0.f)
+		return;
+	const float invTotal{ 1.f / total };
+
+	const float invZ0{ 1.f / vertex0.position.z };
+	const float invZ1{ 1.f / vertex1.position.z };
+	const float invZ2{ 1.f / vertex2.position.z };
+
+#if defined(__AVX2__)
+	const __m256 offsetX{ _mm256_load_ps(m_SampleOffsetX) };
+	const __m256 offsetY{ _mm256_load_ps(m_SampleOffsetY) };
+	const __m256i laneMask{ _mm256_cmpgt_epi32(_mm256_set1_epi32(m_SampleCount), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)) };
+	const __m256 zero{ _mm256_setzero_ps() };
+#endif
+
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		for (int px{ minX }; px < maxX; ++px)
+		{
+			const size_t pixelIndex{ size_t(px) + size_t(py) * m_Width };
+			float* pDepth{ m_pSampleDepth + pixelIndex * m_SampleCount };
+
+			//Coverage and depth test for every sample at once
+			uint16_t passed{};
+#if defined(__AVX2__)
+			const __m256 sampleX{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(px)), offsetX) };
+			const __m256 sampleY{ _mm256_add_ps(_mm256_set1_ps(static_cast<float>(py)), offsetY) };
+			const auto edgeFunction = [&](const Vector2& edge, const Vector2& origin)
+				{
+					const __m256 dx{ _mm256_sub_ps(sampleX, _mm256_set1_ps(origin.x)) };
+					const __m256 dy{ _mm256_sub_ps(sampleY, _mm256_set1_ps(origin.y)) };
+					return _mm256_fmsub_ps(_mm256_set1_ps(edge.x), dy, _mm256_mul_ps(_mm256_set1_ps(edge.y), dx));
+				};
+			const __m256 w0{ edgeFunction(edge0, v1) };
+			const __m256 w1{ edgeFunction(edge1, v2) };
+			const __m256 w2{ edgeFunction(edge2, v0) };
+
+			__m256 inside{ _mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ), _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)) };
+			inside = _mm256_and_ps(_mm256_and_ps(inside, _mm256_cmp_ps(w2, zero, _CMP_GE_OQ)), _mm256_castsi256_ps(laneMask));
+			if (_mm256_movemask_ps(inside) == 0)
+			{
+				++m_Statistics.boundingBoxPixelsRejected;
+				continue;
+			}
+			++m_Statistics.pixelsTested;
+			CountHeat(HeatmapMode::Overdraw, px, py);
+
+			const __m256 interpolatedInvZ{ _mm256_fmadd_ps(w0, _mm256_set1_ps(invZ0), _mm256_fmadd_ps(w1, _mm256_set1_ps(invZ1), _mm256_mul_ps(w2, _mm256_set1_ps(invZ2)))) };
+			const __m256 depth{ _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_mul_ps(interpolatedInvZ, _mm256_set1_ps(invTotal))) };
+			const __m256 storedDepth{ _mm256_maskload_ps(pDepth, laneMask) };
+			const __m256 pass{ _mm256_and_ps(inside, _mm256_cmp_ps(depth, storedDepth, _CMP_LE_OQ)) };
+
+			passed = static_cast<uint16_t>(_mm256_movemask_ps(pass));
+			if (passed == 0)
+				continue;
+			_mm256_maskstore_ps(pDepth, _mm256_castps_si256(pass), depth);
+#else
+			bool isInside{ false };
+			for (int sample{}; sample < m_SampleCount; ++sample)
+			{
+				const float x{ px + m_SampleOffsetX[sample] };
+				const float y{ py + m_SampleOffsetY[sample] };
+				float w0{}, w1{}, w2{};
+				edgeFunctions(x, y, w0, w1, w2);
+				if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+				isInside = true;
+
+				const float depth{ 1 / ((w0 * invZ0 + w1 * invZ1 + w2 * invZ2) * invTotal) };
+				if (pDepth[sample] < depth) continue;
+
+				pDepth[sample] = depth;
+				passed |= 1 << sample;
+			}
+			if (!isInside)
+			{
+				++m_Statistics.boundingBoxPixelsRejected;
+				continue;
+			}
+			++m_Statistics.pixelsTested;
+			CountHeat(HeatmapMode::Overdraw, px, py);
+			if (passed == 0)
+				continue;
+#endif
+			++m_Statistics.pixelsDepthPassed;
+
+			//Shade once, where the non-AA path would unless that point is outside the triangle, then at the first visible sample
+			float weight0{}, weight1{}, weight2{};
+			edgeFunctions(static_cast<float>(px), static_cast<float>(py), weight0, weight1, weight2);
+			if (weight0 < 0 || weight1 < 0 || weight2 < 0)
+			{
+				const int sample{ std::countr_zero(passed) };
+				edgeFunctions(px + m_SampleOffsetX[sample], py + m_SampleOffsetY[sample], weight0, weight1, weight2);
+			}
+			weight0 *= invTotal;
+			weight1 *= invTotal;
+			weight2 *= invTotal;
+
+			if (m_RenderDepth)
+			{
+				const float depthColor{ Utils::Remap(1 / (weight0 * invZ0 + weight1 * invZ1 + weight2 * invZ2), 0.985f, 1.f) };
+				WriteSamples(PackColor(ColorRGB{ depthColor, depthColor, depthColor }), px, py, passed);
+				continue;
+			}
+
+			++m_Statistics.shadingInvocations;
+			++m_Statistics.pixelsShaded;
+			CountHeat(HeatmapMode::ShadeCount, px, py);
+
+			const Vertex_Out shadingVertex{ InterpolateVertex(vertex0, vertex1, vertex2, weight0, weight1, weight2) };
+			if (m_UseSIMDShading)
+			{
+				AddToFragmentBatch(shadingVertex, px, py, 1, passed);
+				continue;
+			}
+
+			WriteSamples(PackColor(PixelShading(shadingVertex)), px, py, passed);
+		}
+	}
+}
+
+void Renderer::WriteSamples(uint32_t pixel, int px, int py, uint16_t coverage)
+{
+	const size_t pixelIndex{ size_t(px) + size_t(py) * m_Width };
+	uint32_t& block{ m_pMsaaBlocks[pixelIndex] };
+
+	//Covering every sample makes the pixel a single color again, its old block is simply dropped until the next frame
+	if (coverage == (1 << m_SampleCount) - 1)
+	{
+		block = NoSampleBlock;
+		m_pMsaaColors[pixelIndex] = pixel;
+		return;
+	}
+
+	if (block == NoSampleBlock)
+	{
+		if (m_pMsaaColors[pixelIndex] == pixel)
+			return;
+
+		block = static_cast<uint32_t>(m_MsaaSamples.size());
+		m_MsaaSamples.resize(m_MsaaSamples.size() + m_SampleCount, m_pMsaaColors[pixelIndex]);
+	}
+
+	for (uint32_t samples{ coverage }; samples != 0; samples &= samples - 1)
+		m_MsaaSamples[block + std::countr_zero(samples)] = pixel;
+}
+
+void Renderer::ResolveSamples()
+{
+	//Only tiles touched this frame, ClearUntouchedTiles fills the others
+	for (int tileY{}; tileY < m_TilesY; ++tileY)
+	{
+		for (int tileX{}; tileX < m_TilesX; ++tileX)
+		{
+			if (m_pColorTarget->tiles[tileX + tileY * m_TilesX].clearedFrame != m_FrameIndex)
+				continue;
+
+			const int startX{ tileX * TileSize };
+			const int width{ std::min(TileSize, m_Width - startX) };
+			for (int y{ tileY * TileSize }; y < std::min((tileY + 1) * TileSize, m_Height); ++y)
+			{
+				const size_t rowStart{ size_t(startX) + size_t(y) * m_Width };
+				int x{};
+#if defined(__AVX2__)
+				//Most pixels hold a single color and are copied 8 at a time, only edge pixels average their samples
+				for (; x + 8 <= width; x += 8)
+				{
+					const size_t i{ rowStart + x };
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(m_pBackBufferPixels + i), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_pMsaaColors + i)));
+
+					const __m256i isSingleColor{ _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_pMsaaBlocks + i)), _mm256_set1_epi32(-1)) };
+					for (uint32_t edges{ ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(isSingleColor))) & 0xFF }; edges != 0; edges &= edges - 1)
+					{
+						const size_t pixelIndex{ i + std::countr_zero(edges) };
+						m_pBackBufferPixels[pixelIndex] = AverageSamples(m_pMsaaBlocks[pixelIndex]);
+					}
+				}
+#endif
+				for (; x < width; ++x)
+				{
+					const size_t pixelIndex{ rowStart + x };
+					const uint32_t block{ m_pMsaaBlocks[pixelIndex] };
+					m_pBackBufferPixels[pixelIndex] = block == NoSampleBlock ? m_pMsaaColors[pixelIndex] : AverageSamples(block);
+				}
+			}
+		}
+	}
+}
+
+uint32_t Renderer::AverageSamples(uint32_t block) const
+{
+	const uint32_t* pSamples{ m_MsaaSamples.data() + block };
+#if defined(__AVX2__)
+	//Channels widened to 16 bits, 4 samples per load, sums of 8 samples still fit
+	const auto sumChannels = [](const uint32_t* pFourSamples)
+		{
+			const __m128i samples{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pFourSamples)) };
+			return _mm_add_epi16(_mm_cvtepu8_epi16(samples), _mm_cvtepu8_epi16(_mm_srli_si128(samples, 8)));
+		};
+
+	__m128i sum{ sumChannels(pSamples) };
+	if (m_SampleCount == 8)
+		sum = _mm_add_epi16(sum, sumChannels(pSamples + 4));
+	sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+
+	//Rounded divide, sample counts are powers of two
+	const __m128i shift{ _mm_cvtsi32_si128(m_SampleCount == 8 ? 3 : 2) };
+	sum = _mm_srl_epi16(_mm_add_epi16(sum, _mm_set1_epi16(static_cast<short>(m_SampleCount / 2))), shift);
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+#else
+	uint32_t result{};
+	for (uint32_t shift{}; shift < 32; shift += 8)
+	{
+		uint32_t sum{};
+		for (int sample{}; sample < m_SampleCount; ++sample)
+			sum += (pSamples[sample] >> shift) & 0xFF;
+		result |= (sum + m_SampleCount / 2) / m_SampleCount << shift;
+	}
+	return result;
+#endif
+}
+
+bool Renderer::SaveBufferToImage(const char* filePath) const
+{
+	//The present thread might still be blitting from this target
+	if (m_pPresenter)
+		m_pPresenter->Flush();
+	if (m_RenderWidth == m_Width && m_RenderHeight == m_Height)
+		return SDL_SaveBMP(m_pBackBuffer, filePath) == 0;
+
+	//Only the rendered part, the rest of the target holds older frames
+	SDL_Surface* pFrame{ SDL_CreateRGBSurfaceFrom(m_pBackBufferPixels, m_RenderWidth, m_RenderHeight, 32, m_Width * 4, 0x00FF0000, 0x0000FF00, 0x000000FF, 0) };
+	const bool isSaved{ SDL_SaveBMP(pFrame, filePath) == 0 };
+	SDL_FreeSurface(pFrame);
+	return isSaved;
+}
+
+void Renderer::SetCamera(const Vector3& origin, float pitch, float yaw, float fovAngle)
+{
+	m_Camera.totalPitch = pitch;
+	m_Camera.totalYaw = yaw;
+	m_Camera.Initialize(fovAngle, origin, m_FrameWidth / static_cast<float>(m_FrameHeight));
+	m_Camera.updateONB = true;
+	m_Camera.CalculateViewMatrix();
+}
+
+void Renderer::SetMeshRotation(float yaw)
+{
+	const std::vector<Mesh>& startMeshes{ m_pScene->GetMeshes() };
+	for (size_t i{}; i < m_Meshes.size(); ++i)
+		m_Meshes[i].worldMatrix = Matrix::CreateRotationY(yaw * TO_RADIANS) * startMeshes[i].worldMatrix;
 }
 
 void Renderer::Render_W1_Part1()
@@ -321,7 +1312,7 @@ void Renderer::Render_W1_Part1()
 			//Update Color in Buffer
 			finalColor.MaxToOne();
 
-			m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+			m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 				static_cast<uint8_t>(finalColor.r * 255),
 				static_cast<uint8_t>(finalColor.g * 255),
 				static_cast<uint8_t>(finalColor.b * 255));
@@ -359,7 +1350,7 @@ void Renderer::Render_W1_Part2()
 			//Update Color in Buffer
 			finalColor.MaxToOne();
 
-			m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+			m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 				static_cast<uint8_t>(finalColor.r * 255),
 				static_cast<uint8_t>(finalColor.g * 255),
 				static_cast<uint8_t>(finalColor.b * 255));
@@ -409,7 +1400,7 @@ void Renderer::Render_W1_Part3()
 			//Update Color in Buffer
 			finalColor.MaxToOne();
 
-			m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+			m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 				static_cast<uint8_t>(finalColor.r * 255),
 				static_cast<uint8_t>(finalColor.g * 255),
 				static_cast<uint8_t>(finalColor.b * 255));
@@ -420,7 +1411,7 @@ void Renderer::Render_W1_Part3()
 void Renderer::Render_W1_Part4()
 {
 	SDL_FillRect(m_pBackBuffer, NULL, 0);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
 
 	const std::vector<Vertex> vertices_world
 	{
@@ -467,15 +1458,15 @@ void Renderer::Render_W1_Part4()
 
 					const float currentDepth = vertex0.position.z * w0 + vertex1.position.z * w1 + vertex2.position.z * w2;
 
-					if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+					if (m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] >= currentDepth)
 					{
-						m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
+						m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] = currentDepth;
 
 						finalColor = vertex0.color * w0 + vertex1.color * w1 + vertex2.color * w2;
 						//Update Color in Buffer
 						finalColor.MaxToOne();
 
-						m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+						m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 							static_cast<uint8_t>(finalColor.r * 255),
 							static_cast<uint8_t>(finalColor.g * 255),
 							static_cast<uint8_t>(finalColor.b * 255));
@@ -489,7 +1480,7 @@ void Renderer::Render_W1_Part4()
 void Renderer::Render_W1_Part5()
 {
 	SDL_FillRect(m_pBackBuffer, NULL, 0x111111);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
 
 	const std::vector<Vertex> vertices_world
 	{
@@ -564,15 +1555,15 @@ void Renderer::Render_W1_Part5()
 
 					const float currentDepth = vertex0.position.z * w0 + vertex1.position.z * w1 + vertex2.position.z * w2;
 
-					if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+					if (m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] >= currentDepth)
 					{
-						m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
+						m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] = currentDepth;
 
 						finalColor = vertex0.color * w0 + vertex1.color * w1 + vertex2.color * w2;
 						//Update Color in Buffer
 						finalColor.MaxToOne();
 
-						m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+						m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 							static_cast<uint8_t>(finalColor.r * 255),
 							static_cast<uint8_t>(finalColor.g * 255),
 							static_cast<uint8_t>(finalColor.b * 255));
@@ -589,7 +1580,7 @@ void Renderer::Render_W2_Part1()
 	ColorRGB clearColor = ColorRGB{ 100,100,100 };
 	Uint32 clearColorUint = 0xFF000000 | (Uint32)clearColor.r | (Uint32)clearColor.b << 16 | (Uint32)clearColor.g << 8;
 	SDL_FillRect(m_pBackBuffer, NULL, clearColorUint);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
 
 	std::vector<Mesh> meshes_world
 	{
@@ -692,15 +1683,15 @@ void Renderer::Render_W2_Part1()
 
 						const float currentDepth = vertex0.position.z * w0 + vertex1.position.z * w1 + vertex2.position.z * w2;
 
-						if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+						if (m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] >= currentDepth)
 						{
-							m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
+							m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] = currentDepth;
 
 							finalColor = vertex0.color * w0 + vertex1.color * w1 + vertex2.color * w2;
 							//Update Color in Buffer
 							finalColor.MaxToOne();
 
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+							m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 								static_cast<uint8_t>(finalColor.r * 255),
 								static_cast<uint8_t>(finalColor.g * 255),
 								static_cast<uint8_t>(finalColor.b * 255));
@@ -715,7 +1706,7 @@ void Renderer::Render_W2_Part1()
 void Renderer::Render_W2_Part2()
 {
 	SDL_FillRect(m_pBackBuffer, NULL, 0x111111);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
 
 	std::vector<Mesh> meshes_world
 	{
@@ -813,15 +1804,15 @@ void Renderer::Render_W2_Part2()
 
 						const float currentDepth = vertex0.position.z * w0 + vertex1.position.z * w1 + vertex2.position.z * w2;
 
-						if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+						if (m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] >= currentDepth)
 						{
-							m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
+							m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] = currentDepth;
 
 							finalColor = vertex0.color * w0 + vertex1.color * w1 + vertex2.color * w2;
 							//Update Color in Buffer
 							finalColor.MaxToOne();
 
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+							m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 								static_cast<uint8_t>(finalColor.r * 255),
 								static_cast<uint8_t>(finalColor.g * 255),
 								static_cast<uint8_t>(finalColor.b * 255));
@@ -836,7 +1827,7 @@ void Renderer::Render_W2_Part2()
 void Renderer::Render_W2_Part3()
 {
 	SDL_FillRect(m_pBackBuffer, NULL, 0x111111);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
 
 	std::vector<Mesh> meshes_world
 	{
@@ -945,9 +1936,9 @@ void Renderer::Render_W2_Part3()
 						//const float currentDepth = vertex0.position.z * w0 + vertex1.position.z * w1 + vertex2.position.z * w2;
 						const float currentDepth = 1 / (1 / vertex0.position.z * w0 + 1 / vertex1.position.z * w1 + 1 / vertex2.position.z * w2);
 
-						if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+						if (m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] >= currentDepth)
 						{
-							m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
+							m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] = currentDepth;
 
 							//finalColor = vertex0.color * w0 + vertex1.color * w1 + vertex2.color * w2;
 							//Vector2 uv{ vertex0.uv * w0 + vertex1.uv * w1 + vertex2.uv * w2 };
@@ -958,7 +1949,7 @@ void Renderer::Render_W2_Part3()
 							//Update Color in Buffer
 							finalColor.MaxToOne();
 
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+							m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 								static_cast<uint8_t>(finalColor.r * 255),
 								static_cast<uint8_t>(finalColor.g * 255),
 								static_cast<uint8_t>(finalColor.b * 255));
@@ -973,48 +1964,23 @@ void Renderer::Render_W2_Part3()
 void Renderer::Render_W3_Part1()
 {
 	SDL_FillRect(m_pBackBuffer, NULL, 0x111111);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
 
 	VertexTransformationFunction(m_Meshes);
 
 	for (const Mesh& mesh : m_Meshes)
 	{
-		size_t size = (mesh.primitiveTopology == PrimitiveTopology::TriangleList) ? mesh.indices.size() / 3 : mesh.indices.size() - 2;
+		TriangleAssembler assembler{ mesh.GetIndices(), mesh.GetPrimitiveTopology() };
+		const size_t size{ assembler.GetStepCount() };
 		for (size_t i = 0; i < size; i++)
 		{
-			Vertex_Out vertex0{};
-			Vertex_Out vertex1{};
-			Vertex_Out vertex2{};
+			uint32_t triangle[3]{};
+			if (!assembler.Assemble(i, triangle))
+				continue;
 
-			switch (mesh.primitiveTopology)
-			{
-			case PrimitiveTopology::TriangleList:
-				vertex0 = mesh.vertices_out[mesh.indices[i * 3]];
-				vertex1 = mesh.vertices_out[mesh.indices[i * 3 + 1]];
-				vertex2 = mesh.vertices_out[mesh.indices[i * 3 + 2]];
-				break;
-			case PrimitiveTopology::TriangleStrip:
-				if (mesh.indices[i] == mesh.indices[i + 1] || mesh.indices[i + 1] == mesh.indices[i + 2])
-				{
-					continue; // new strip, skip;
-				}
-
-				if (i % 2 == 0)
-				{
-					//Clockwise
-					vertex0 = mesh.vertices_out[mesh.indices[i]];
-					vertex1 = mesh.vertices_out[mesh.indices[i + 1]];
-					vertex2 = mesh.vertices_out[mesh.indices[i + 2]];
-				}
-				else
-				{
-					//Counter Clockwise
-					vertex0 = mesh.vertices_out[mesh.indices[i]];
-					vertex1 = mesh.vertices_out[mesh.indices[i + 2]];
-					vertex2 = mesh.vertices_out[mesh.indices[i + 1]];
-				}
-				break;
-			}
+			Vertex_Out vertex0{ mesh.vertices_out[triangle[0]] };
+			Vertex_Out vertex1{ mesh.vertices_out[triangle[1]] };
+			Vertex_Out vertex2{ mesh.vertices_out[triangle[2]] };
 
 			// Backface Culling
 
@@ -1050,9 +2016,15 @@ void Renderer::Render_W3_Part1()
 			bbMinX = static_cast<int>(std::min(vertex0.position.x, std::min(vertex1.position.x, vertex2.position.x)));
 			bbMinY = static_cast<int>(std::min(vertex0.position.y, std::min(vertex1.position.y, vertex2.position.y)));
 
-			for (int px{ bbMinX - 1 }; px < bbMaxX + 1; ++px)
+			//The one pixel margin must not leave the buffer for triangles touching the frame edge
+			const int minX{ std::max(bbMinX - 1, 0) };
+			const int minY{ std::max(bbMinY - 1, 0) };
+			const int maxX{ std::min(bbMaxX + 1, m_Width) };
+			const int maxY{ std::min(bbMaxY + 1, m_Height) };
+
+			for (int px{ minX }; px < maxX; ++px)
 			{
-				for (int py{ bbMinY - 1 }; py < bbMaxY + 1; ++py)
+				for (int py{ minY }; py < maxY; ++py)
 				{
 					if (m_RenderBoundingBox)
 					{
@@ -1060,7 +2032,7 @@ void Renderer::Render_W3_Part1()
 						//Update Color in Buffer
 						finalColor.MaxToOne();
 
-						m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+						m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 							static_cast<uint8_t>(finalColor.r * 255),
 							static_cast<uint8_t>(finalColor.g * 255),
 							static_cast<uint8_t>(finalColor.b * 255));
@@ -1089,9 +2061,9 @@ void Renderer::Render_W3_Part1()
 
 						const float currentDepth = 1 / (1 / vertex0.position.z * w0 + 1 / vertex1.position.z * w1 + 1 / vertex2.position.z * w2);
 
-						if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+						if (m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] >= currentDepth)
 						{
-							m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
+							m_pDepthBufferPixels[size_t(px) + size_t(py) * m_Width] = currentDepth;
 
 							
 							ColorRGB finalColor{};
@@ -1111,7 +2083,7 @@ void Renderer::Render_W3_Part1()
 							//Update Color in Buffer
 							finalColor.MaxToOne();
 
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
+							m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = SDL_MapRGB(m_pBackBuffer->format,
 								static_cast<uint8_t>(finalColor.r * 255),
 								static_cast<uint8_t>(finalColor.g * 255),
 								static_cast<uint8_t>(finalColor.b * 255));
@@ -1125,74 +2097,61 @@ void Renderer::Render_W3_Part1()
 
 void Renderer::Render_W4_Part1()
 {
-	SDL_FillRect(m_pBackBuffer, NULL, 0x111111);
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	m_Statistics = {};
 
-	VertexTransformationFunction(m_Meshes);
+	//No full clear, tiles are cleared when first touched and the rest after rasterization
+	{
+		PROFILE_ZONE("BeginFrame");
+		BeginFrame();
+	}
+
+	//Bounding boxes are drawn straight into the back buffer, they have nothing to resolve
+	m_MultisampledFrame = m_SampleCount > 1 && !m_RenderBoundingBox;
+
+	{
+		PROFILE_ZONE("VertexTransformation");
+		VertexTransformationFunction(m_Meshes);
+	}
 
+	//Assembly, rasterization and shading interleave per triangle, batched shading shows up as one summed zone at the end.
+	//Shading one cell at a time (F10 off) stays part of this zone, timing every cell would cost more than shading it.
+	PROFILE_ZONE("Rasterization");
 	for (const Mesh& mesh : m_Meshes)
 	{
-		size_t size = (mesh.primitiveTopology == PrimitiveTopology::TriangleList) ? mesh.indices.size() / 3 : mesh.indices.size() - 2;
+		TriangleAssembler assembler{ mesh.GetIndices(), mesh.GetPrimitiveTopology() };
+		const size_t size{ assembler.GetStepCount() };
 		for (size_t i = 0; i < size; i++)
 		{
-			Vertex_Out vertex0{};
-			Vertex_Out vertex1{};
-			Vertex_Out vertex2{};
+			uint32_t triangle[3]{};
+			if (!assembler.Assemble(i, triangle))
+				continue;
 
-			switch (mesh.primitiveTopology)
-			{
-			case PrimitiveTopology::TriangleList:
-				vertex0 = mesh.vertices_out[mesh.indices[i * 3]];
-				vertex1 = mesh.vertices_out[mesh.indices[i * 3 + 1]];
-				vertex2 = mesh.vertices_out[mesh.indices[i * 3 + 2]];
-				break;
-			case PrimitiveTopology::TriangleStrip:
-				if (mesh.indices[i] == mesh.indices[i + 1] || mesh.indices[i + 1] == mesh.indices[i + 2])
-				{
-					continue; // new strip, skip;
-				}
-
-				if (i % 2 == 0)
-				{
-					//Clockwise
-					vertex0 = mesh.vertices_out[mesh.indices[i]];
-					vertex1 = mesh.vertices_out[mesh.indices[i + 1]];
-					vertex2 = mesh.vertices_out[mesh.indices[i + 2]];
-				}
-				else
-				{
-					//Counter Clockwise
-					vertex0 = mesh.vertices_out[mesh.indices[i]];
-					vertex1 = mesh.vertices_out[mesh.indices[i + 2]];
-					vertex2 = mesh.vertices_out[mesh.indices[i + 1]];
-				}
-				break;
-			}
+			Vertex_Out vertex0{ mesh.vertices_out[triangle[0]] };
+			Vertex_Out vertex1{ mesh.vertices_out[triangle[1]] };
+			Vertex_Out vertex2{ mesh.vertices_out[triangle[2]] };
 
-			// Backface / frontface Culling
+			++m_Statistics.trianglesSubmitted;
 
 			// Frustrum Clulling
 			// X and Y between -1 and 1
 			// Z between 0 and 1 following directX convention
-			if (vertex0.position.x < -1.f || vertex0.position.x > 1.f) continue;
-			if (vertex0.position.y < -1.f || vertex0.position.y > 1.f) continue;
-			if (vertex0.position.z < 0 || vertex0.position.z > 1.f) continue;
-
-			if (vertex1.position.x < -1.f || vertex1.position.x > 1.f) continue;
-			if (vertex1.position.y < -1.f || vertex1.position.y > 1.f) continue;
-			if (vertex1.position.z < 0 || vertex1.position.z > 1.f) continue;
-
-			if (vertex2.position.x < -1.f || vertex2.position.x > 1.f) continue;
-			if (vertex2.position.y < -1.f || vertex2.position.y > 1.f) continue;
-			if (vertex2.position.z < 0 || vertex2.position.z > 1.f) continue;
+			const auto isOutside = [](const Vertex_Out& vertex)
+				{
+					return vertex.position.x < -1.f || vertex.position.x > 1.f || vertex.position.y < -1.f || vertex.position.y > 1.f || vertex.position.z < 0 || vertex.position.z > 1.f;
+				};
+			if (isOutside(vertex0) || isOutside(vertex1) || isOutside(vertex2))
+			{
+				++m_Statistics.trianglesFrustumCulled;
+				continue;
+			}
 
 			//Projection TO NDC/Raster/Screen Space
-			vertex0.position.x = (vertex0.position.x + 1) / 2.f * m_Width;
-			vertex0.position.y = (1 - vertex0.position.y) / 2.f * m_Height;
-			vertex1.position.x = (vertex1.position.x + 1) / 2.f * m_Width;
-			vertex1.position.y = (1 - vertex1.position.y) / 2.f * m_Height;
-			vertex2.position.x = (vertex2.position.x + 1) / 2.f * m_Width;
-			vertex2.position.y = (1 - vertex2.position.y) / 2.f * m_Height;
+			vertex0.position.x = (vertex0.position.x + 1) / 2.f * m_FrameWidth - m_FrameX;
+			vertex0.position.y = (1 - vertex0.position.y) / 2.f * m_FrameHeight - m_FrameY;
+			vertex1.position.x = (vertex1.position.x + 1) / 2.f * m_FrameWidth - m_FrameX;
+			vertex1.position.y = (1 - vertex1.position.y) / 2.f * m_FrameHeight - m_FrameY;
+			vertex2.position.x = (vertex2.position.x + 1) / 2.f * m_FrameWidth - m_FrameX;
+			vertex2.position.y = (1 - vertex2.position.y) / 2.f * m_FrameHeight - m_FrameY;
 
 
 			int bbMaxX{}, bbMaxY{};
@@ -1203,99 +2162,160 @@ void Renderer::Render_W4_Part1()
 			bbMinX = static_cast<int>(std::min(vertex0.position.x, std::min(vertex1.position.x, vertex2.position.x)));
 			bbMinY = static_cast<int>(std::min(vertex0.position.y, std::min(vertex1.position.y, vertex2.position.y)));
 
-			for (int px{ bbMinX - 1 }; px < bbMaxX + 1; ++px)
+			//Samples sit up to half a pixel right/below the pixel's point, so the next pixel can still be covered
+			const int samplePadding{ m_MultisampledFrame ? 1 : 0 };
+			const int minX{ std::max(bbMinX - 1, 0) };
+			const int minY{ std::max(bbMinY - 1, 0) };
+			const int maxX{ std::min(bbMaxX + 1 + samplePadding, m_RenderWidth) };
+			const int maxY{ std::min(bbMaxY + 1 + samplePadding, m_RenderHeight) };
+			if (minX >= maxX || minY >= maxY)
 			{
-				for (int py{ bbMinY - 1 }; py < bbMaxY + 1; ++py)
+				//Outside the render rect of a frame rendered in pieces
+				++m_Statistics.trianglesOutsideRenderRect;
+				continue;
+			}
+
+			ClearTiles(minX, minY, maxX, maxY);
+
+			if (m_RenderBoundingBox)
+			{
+				for (int px{ minX }; px < maxX; ++px)
 				{
-					if (m_RenderBoundingBox)
+					for (int py{ minY }; py < maxY; ++py)
 					{
-						ColorRGB finalColor{ 1,1,1 };
-						//Update Color in Buffer
-						finalColor.MaxToOne();
-
-						m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-							static_cast<uint8_t>(finalColor.r * 255),
-							static_cast<uint8_t>(finalColor.g * 255),
-							static_cast<uint8_t>(finalColor.b * 255));
-						continue;
+						m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = PackColor(colors::White);
 					}
+				}
+				continue;
+			}
 
-					const Vector2 p{ static_cast<float>(px), static_cast<float>(py) };
+			const Vector2 v0{ vertex0.position.GetXY() };
+			const Vector2 v1{ vertex1.position.GetXY() };
+			const Vector2 v2{ vertex2.position.GetXY() };
 
+			// Backface Culling
+			// Back facing and degenerate triangles fail the edge test at every pixel of their bounding box
+			if (Vector2::Cross(v1 - v0, v2 - v0) <= 0.f)
+			{
+				++m_Statistics.trianglesBackfaceCulled;
+				continue;
+			}
 
-					const Vector2 v0{ vertex0.position.GetXY() };
-					const Vector2 v1{ vertex1.position.GetXY() };
-					const Vector2 v2{ vertex2.position.GetXY() };
+			++m_Statistics.trianglesRasterized;
+			m_Statistics.boundingBoxPixels += uint64_t(maxX - minX) * (maxY - minY);
 
-					float w0{ Vector2::Cross(v2 - v1, p - v1) }; //same as triangle hit test
-					if (w0 < 0) continue; // Point is not in triangle 
-					float w1{ Vector2::Cross(v0 - v2, p - v2) }; //NOT the same as triangle hit test
-					if (w1 < 0) continue; // Point is not in triangle
-					float w2{ Vector2::Cross(v1 - v0, p - v0) }; //same as triangle hit test
-					if (w2 < 0) continue; // Point is not in triangle
+			if (m_MultisampledFrame)
+			{
+				RasterizeMultisampled(vertex0, vertex1, vertex2, minX, minY, maxX, maxY);
+				continue;
+			}
 
-					const float total{ w0 + w1 + w2 };
-					w0 /= total;
-					w1 /= total;
-					w2 /= total;
+			const ShadingRate meshRate{ std::max(m_ShadingRate, mesh.shadingRate) };
 
-					const float currentDepth = 1 / (1 / vertex0.position.z * w0 + 1 / vertex1.position.z * w1 + 1 / vertex2.position.z * w2);
+			// Walk the bounding box in 4x4 blocks, the shading rate is constant within one block
+			for (int blockY{ minY & ~3 }; blockY < maxY; blockY += 4)
+			{
+				for (int blockX{ minX & ~3 }; blockX < maxX; blockX += 4)
+				{
+					const int rate{ GetShadingRate(meshRate, blockX + 2, blockY + 2) };
 
-					if (m_pDepthBufferPixels[px + (py * m_Width)] >= currentDepth)
+					for (int shadeY{ blockY }; shadeY < blockY + 4; shadeY += rate)
 					{
-						m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
-
-
-						ColorRGB finalColor{};
-						if (m_RenderDepth)
-						{
-							float depthColor{ Utils::Remap(currentDepth, 0.985f, 1.f) };
-							finalColor = ColorRGB{ depthColor, depthColor, depthColor };
-						}
-						else
+						for (int shadeX{ blockX }; shadeX < blockX + 4; shadeX += rate)
 						{
-							const float wInterpolated = 1 / (1 / vertex0.position.w * w0 + 1 / vertex1.position.w * w1 + 1 / vertex2.position.w * w2);
-							
-							/*const Vector2 uv = (vertex0.uv / vertex0.position.w * w0 + vertex1.uv / vertex1.position.w * w1 + vertex2.uv / vertex2.position.w * w2) * wInterpolated;
-							finalColor = m_pTexture->Sample(uv);*/
-
-							Vertex_Out interpolatedVertex{};
-							//interpolatedVertex.color = (vertex0.color / vertex0.position.w * w0 + vertex1.color / vertex1.position.w * w1 + vertex2.color / vertex2.position.w * w2) * wInterpolated;
-							interpolatedVertex.normal = ((vertex0.normal / vertex0.position.w * w0 + vertex1.normal / vertex1.position.w * w1 + vertex2.normal / vertex2.position.w * w2) * wInterpolated).Normalized();
-							
-							const Vector2 interpolatedXY{ (v0 / vertex0.position.w * w0 + v1 / vertex1.position.w * w1 + v2 / vertex2.position.w * w2) * wInterpolated };
-							const float interpolatedZ{ 1 / (1 / vertex0.position.z * w0 + 1 / vertex1.position.z * w1 + 1 / vertex2.position.z * w2) };
-							const float interpolatedW{ 1 / (1 / vertex0.position.w * w0 + 1 / vertex1.position.w * w1 + 1 / vertex2.position.w * w2) };
-							Vector4 interpolatedPos{ interpolatedXY.x, interpolatedXY.y, interpolatedZ, interpolatedW };
-							interpolatedVertex.position = interpolatedPos;
-							
-							interpolatedVertex.tangent = ((vertex0.tangent / vertex0.position.w * w0 + vertex1.tangent / vertex1.position.w * w1 + vertex2.tangent / vertex2.position.w * w2) * wInterpolated).Normalized();;
-							interpolatedVertex.uv = (vertex0.uv / vertex0.position.w * w0 + vertex1.uv / vertex1.position.w * w1 + vertex2.uv / vertex2.position.w * w2) * wInterpolated;
-							interpolatedVertex.viewDirection = (vertex0.viewDirection / vertex0.position.w * w0 + vertex1.viewDirection / vertex1.position.w * w1 + vertex2.viewDirection / vertex2.position.w * w2) * wInterpolated;
+							// PixelShading runs at most once per rate x rate cell, on the first pixel that passes the depth test
+							uint16_t coverage{};
+							Vertex_Out shadingVertex{};
 
-							finalColor = PixelShading(interpolatedVertex);
+							for (int py{ std::max(shadeY, minY) }; py < std::min(shadeY + rate, maxY); ++py)
+							{
+								for (int px{ std::max(shadeX, minX) }; px < std::min(shadeX + rate, maxX); ++px)
+								{
+									const Vector2 p{ static_cast<float>(px), static_cast<float>(py) };
+
+									float w0{ Vector2::Cross(v2 - v1, p - v1) }; //same as triangle hit test
+									if (w0 < 0) { ++m_Statistics.boundingBoxPixelsRejected; continue; } // Point is not in triangle 
+									float w1{ Vector2::Cross(v0 - v2, p - v2) }; //NOT the same as triangle hit test
+									if (w1 < 0) { ++m_Statistics.boundingBoxPixelsRejected; continue; } // Point is not in triangle
+									float w2{ Vector2::Cross(v1 - v0, p - v0) }; //same as triangle hit test
+									if (w2 < 0) { ++m_Statistics.boundingBoxPixelsRejected; continue; } // Point is not in triangle
+
+									++m_Statistics.pixelsTested;
+									CountHeat(HeatmapMode::Overdraw, px, py);
+
+									const float total{ w0 + w1 + w2 };
+									w0 /= total;
+									w1 /= total;
+									w2 /= total;
+
+									const float currentDepth = 1 / (1 / vertex0.position.z * w0 + 1 / vertex1.position.z * w1 + 1 / vertex2.position.z * w2);
+
+									if (!DepthTest(size_t(px) + size_t(py) * m_Width, currentDepth)) continue;
+									++m_Statistics.pixelsDepthPassed;
+
+									if (m_RenderDepth)
+									{
+										const float depthColor{ Utils::Remap(currentDepth, 0.985f, 1.f) };
+										m_pBackBufferPixels[size_t(px) + size_t(py) * m_Width] = PackColor(ColorRGB{ depthColor, depthColor, depthColor });
+										continue;
+									}
+
+									if (coverage == 0)
+										shadingVertex = InterpolateVertex(vertex0, vertex1, vertex2, w0, w1, w2);
+									coverage |= 1 << ((py - shadeY) * rate + (px - shadeX));
+									CountHeat(HeatmapMode::ShadeCount, px, py);
+								}
+							}
 
-						}
+							if (coverage == 0)
+								continue;
 
+							++m_Statistics.shadingInvocations;
+							m_Statistics.pixelsShaded += std::popcount(coverage);
 
-						//Update Color in Buffer
-						finalColor.MaxToOne();
+							if (!m_UseSIMDShading)
+							{
+								WriteShadingCell(PackColor(PixelShading(shadingVertex)), shadeX, shadeY, rate, coverage);
+								continue;
+							}
 
-						m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-							static_cast<uint8_t>(finalColor.r * 255),
-							static_cast<uint8_t>(finalColor.g * 255),
-							static_cast<uint8_t>(finalColor.b * 255));
+							AddToFragmentBatch(shadingVertex, shadeX, shadeY, rate, coverage);
+						}
 					}
 				}
 			}
 		}
 	}
+
+	//Shade whatever is left in the last batch
+	FlushFragmentBatch();
+	PROFILE_FLUSH_SUMS();
+
+	if (m_MultisampledFrame)
+	{
+		PROFILE_ZONE("ResolveSamples");
+		ResolveSamples();
+	}
+	{
+		PROFILE_ZONE("ClearUntouchedTiles");
+		ClearUntouchedTiles();
+	}
+
+	if (m_HeatmapMode != HeatmapMode::Off)
+		DrawHeatmap();
 }
 
 void Renderer::InputLogic(const SDL_Event& e)
 {
 	switch (e.key.keysym.scancode)
 	{
+	case SDL_SCANCODE_F1:
+		PrintStatistics();
+		break;
+	case SDL_SCANCODE_F2:
+		m_HeatmapMode = static_cast<HeatmapMode>((int(m_HeatmapMode) + 1) % (int(HeatmapMode::ShadeCount) + 1));
+		std::cout << "Heatmap : " << (m_HeatmapMode == HeatmapMode::Overdraw ? "Overdraw" : m_HeatmapMode == HeatmapMode::ShadeCount ? "Shade Count" : "Off") << "\n";
+		break;
 	case SDL_SCANCODE_F3:
 		m_RenderBoundingBox = !m_RenderBoundingBox;
 		std::cout << "Render Bounding Boxes : " << m_RenderBoundingBox << "\n";
@@ -1337,14 +2357,76 @@ void Renderer::InputLogic(const SDL_Event& e)
 			break;
 		}
 		break;
+	case SDL_SCANCODE_F8:
+		switch (m_ShadingRate)
+		{
+		case ShadingRate::Rate1x1:
+			m_ShadingRate = ShadingRate::Rate2x2;
+			break;
+		case ShadingRate::Rate2x2:
+			m_ShadingRate = ShadingRate::Rate4x4;
+			break;
+		default:
+			m_ShadingRate = ShadingRate::Rate1x1;
+			break;
+		}
+		std::cout << "Shading Rate : " << int(m_ShadingRate) << "x" << int(m_ShadingRate) << "\n";
+		break;
+	case SDL_SCANCODE_F9:
+		m_FoveatedShading = !m_FoveatedShading;
+		std::cout << "Foveated Shading : " << m_FoveatedShading << "\n";
+		break;
+	case SDL_SCANCODE_F10:
+		m_UseSIMDShading = !m_UseSIMDShading;
+		std::cout << "SIMD Shading : " << m_UseSIMDShading << "\n";
+		break;
+	case SDL_SCANCODE_F11:
+		m_TaggedDepth = !m_TaggedDepth;
+		//Tiles that were cleared lazily never had their depth reset, start over from a full clear
+		std::fill_n(m_pDepthBufferPixels, size_t(m_Width) * m_Height, FLT_MAX);
+		Memory::FreePages(m_pTaggedDepthPixels);
+		m_pTaggedDepthPixels = nullptr;
+		std::cout << "Tagged Depth : " << m_TaggedDepth << "\n";
+		break;
+	case SDL_SCANCODE_F12:
+		SetSampleCount(m_SampleCount == 1 ? 4 : m_SampleCount == 4 ? 8 : 1);
+		std::cout << "MSAA : " << m_SampleCount << "x\n";
+		break;
 	}
 }
 
 void Renderer::PrintInstructions() const
 {
+	std::cout << "F1 : Print Raster Statistics\n";
+	std::cout << "F2 : Heatmap (Overdraw, Shade Count)\n";
 	std::cout << "F3 : Render Bounding Boxes\n";
 	std::cout << "F4 : Render Depth\n";
 	std::cout << "F5 : Rotate Meshes\n";
 	std::cout << "F6 : Render Normal Map\n";
 	std::cout << "F7 : Render Mode\n";
+	std::cout << "F8 : Shading Rate\n";
+	std::cout << "F9 : Foveated Shading\n";
+	std::cout << "F10 : SIMD Shading\n";
+	std::cout << "F11 : Tagged Depth\n";
+	std::cout << "F12 : MSAA\n";
+}
+
+void Renderer::PrintStatistics() const
+{
+	const RasterStatistics& stats{ m_Statistics };
+	const auto percentOf = [](uint64_t part, uint64_t whole) { return whole == 0 ? 0.0 : 100.0 * double(part) / double(whole); };
+	const auto perPixel = [this](uint64_t count) { return double(count) / (double(m_RenderWidth) * m_RenderHeight); };
+
+	std::cout << "Triangles : " << stats.trianglesSubmitted << " submitted, "
+		<< stats.trianglesFrustumCulled << " frustum culled (" << percentOf(stats.trianglesFrustumCulled, stats.trianglesSubmitted) << "%), "
+		<< stats.trianglesOutsideRenderRect << " outside the render rect, "
+		<< stats.trianglesBackfaceCulled << " backface culled (" << percentOf(stats.trianglesBackfaceCulled, stats.trianglesSubmitted) << "%), "
+		<< stats.trianglesRasterized << " rasterized\n";
+	std::cout << "Pixels : " << stats.boundingBoxPixels << " in bounding boxes, "
+		<< stats.boundingBoxPixelsRejected << " outside (" << percentOf(stats.boundingBoxPixelsRejected, stats.boundingBoxPixels) << "%), "
+		<< stats.pixelsTested << " inside (" << percentOf(stats.pixelsTested, stats.boundingBoxPixels) << "%), "
+		<< stats.pixelsDepthPassed << " passed depth (" << percentOf(stats.pixelsDepthPassed, stats.pixelsTested) << "%), "
+		<< stats.pixelsShaded << " shaded by " << stats.shadingInvocations << " shading invocations\n";
+	std::cout << "Per screen pixel : " << perPixel(stats.pixelsTested) << " overdraw, " << perPixel(stats.pixelsShaded) << " shaded, "
+		<< perPixel(stats.shadingInvocations) << " shading invocations\n";
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "Camera.h"
@@ -12,6 +13,8 @@ struct SDL_Surface;
 namespace dae
 {
 	class Texture;
+	class FramePresenter;
+	class DynamicResolution;
 	struct Mesh;
 	struct Vertex;
 	class Timer;
@@ -26,10 +29,56 @@ namespace dae
 		Combined
 	};
 
+	//Which of the Render_ functions Render runs, the earlier ones only stay around to compare against
+	enum class RenderPath
+	{
+		W1_Part1,
+		W1_Part2,
+		W1_Part3,
+		W1_Part4,
+		W1_Part5,
+		W2_Part1,
+		W2_Part2,
+		W2_Part3,
+		W3_Part1,
+		W4_Part1
+	};
+
+	//What W4 did with the geometry of the last frame, summed over every triangle.
+	//Pixels with MSAA count once per pixel whatever number of its samples were covered.
+	struct RasterStatistics
+	{
+		uint64_t trianglesSubmitted{};
+		uint64_t trianglesFrustumCulled{}; //A vertex outside the view frustum
+		uint64_t trianglesOutsideRenderRect{}; //Bounding box misses the band or scaled rect a frame is rendered into
+		uint64_t trianglesBackfaceCulled{}; //Facing away or degenerate
+		uint64_t trianglesRasterized{};
+		uint64_t boundingBoxPixels{}; //Pixels the rasterized triangles tested the edge functions of
+		uint64_t boundingBoxPixelsRejected{}; //Of those, the ones that failed the edge test
+		uint64_t pixelsTested{}; //Inside a triangle, so tested against the depth buffer
+		uint64_t pixelsDepthPassed{};
+		uint64_t shadingInvocations{}; //PixelShading calls, a 2x2 cell shades once
+		uint64_t pixelsShaded{}; //Pixels that received a shaded color, every pixel of a cell counts
+	};
+
+	//W4 only, replaces the colors of the frame with how often each pixel was ...
+	enum class HeatmapMode
+	{
+		Off,
+		Overdraw, //... inside a triangle
+		ShadeCount //... shaded
+	};
+
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
+		//frameQueueDepth is the number of color targets, with more than one the present overlaps the next frame
+		//Without a scene the Renderer loads its own, pass one to share the assets between Renderers
+		Renderer(SDL_Window* pWindow, int frameQueueDepth = 2, std::shared_ptr<const Scene> pScene = nullptr);
+		//Offscreen, renders into its own buffers without a window or SDL video
+		Renderer(int width, int height, std::shared_ptr<const Scene> pScene = nullptr);
+		//Offscreen, renders into caller owned XRGB8888 buffers (width * 4 pitch) picked with SetColorTarget
+		Renderer(int width, int height, const std::vector<uint32_t*>& targetPixels, std::shared_ptr<const Scene> pScene = nullptr);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -40,7 +89,20 @@ namespace dae
 		void Update(Timer* pTimer);
 		void Render();
 
-		bool SaveBufferToImage() const;
+		bool SaveBufferToImage(const char* filePath = "Rasterizer_ColorBuffer.bmp") const;
+
+		bool IsHeadless() const { return m_pWindow == nullptr; }
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+		//Size of the last frame, it starts at GetPixels() and its rows are GetWidth() pixels apart
+		int GetRenderWidth() const { return m_RenderWidth; }
+		int GetRenderHeight() const { return m_RenderHeight; }
+		const uint32_t* GetPixels() const { return m_pBackBufferPixels; }
+		//Headless only, which color target the next Render draws into
+		void SetColorTarget(int targetIndex) { m_HeadlessTarget = targetIndex; }
+		//Headless only. Renders the part of a frameWidth x frameHeight frame that starts at x, y into the buffers,
+		//so frames larger than the buffers are produced piece by piece. The render size shrinks at the frame's edge.
+		void SetFrameRect(int frameWidth, int frameHeight, int x, int y);
 
 		void Render_W1_Part1(); //Rasterizer Stage Only
 		void Render_W1_Part2(); //Projection Stage (Camera)
@@ -61,40 +123,169 @@ namespace dae
 
 		void PrintInstructions() const;
 
+		void SetRenderPath(RenderPath path) { m_RenderPath = path; }
+		void SetShadingRate(ShadingRate rate) { m_ShadingRate = rate; }
+		void SetShadingFocus(const Vector2& focus) { m_ShadingFocus = focus; }
+		//1 (off), 4 or 8 samples per pixel
+		void SetSampleCount(int sampleCount);
+		//Window only. Lowers the render resolution down to minScale of the window when frames take longer than
+		//targetFrameTime (seconds) and raises it again when there is time left, 0 turns it off.
+		void SetDynamicResolution(float targetFrameTime, float minScale = .5f);
+		//Draws the coarsest level of detail of a mesh whose error stays under maxPixelError on screen, 0 always draws the full mesh
+		void SetLodError(float maxPixelError) { m_LodPixelError = maxPixelError; }
+
+		//Fixed viewpoints for offline rendering, angles in degrees
+		void SetCamera(const Vector3& origin, float pitch, float yaw, float fovAngle);
+		//Yaw relative to the start pose of the scene meshes
+		void SetMeshRotation(float yaw);
+
+		const RasterStatistics& GetStatistics() const { return m_Statistics; }
+		void PrintStatistics() const;
+		void SetHeatmapMode(HeatmapMode mode) { m_HeatmapMode = mode; }
+
 	private:
 		SDL_Window* m_pWindow{};
 
 		SDL_Surface* m_pFrontBuffer{ nullptr };
-		SDL_Surface* m_pBackBuffer{ nullptr };
+		SDL_Surface* m_pBackBuffer{ nullptr }; //Color target of the frame being rendered
 		uint32_t* m_pBackBufferPixels{};
 
+		//Back buffer channel layout, read once at construction so pixels are packed without SDL_MapRGB
+		uint32_t m_RedShift{};
+		uint32_t m_GreenShift{};
+		uint32_t m_BlueShift{};
+		uint32_t m_AlphaMask{};
+
 		float* m_pDepthBufferPixels{};
 
+		//W4 lazy clears, a tile is only cleared on the first touch of a frame or at the end of the frame
+		struct TileState
+		{
+			uint32_t clearedFrame{};
+			bool isDirty{ true }; //Holds pixels from an earlier frame
+		};
+		static constexpr int TileSize{ 32 };
+		static constexpr uint32_t ClearColor{ 0x111111 };
+		int m_TilesX{};
+		int m_TilesY{};
+		std::vector<TileState> m_DepthTiles{};
+		uint32_t m_FrameIndex{};
+
+		//Each color target remembers which of its own tiles still hold an old frame
+		struct ColorTarget
+		{
+			SDL_Surface* pSurface{};
+			uint32_t* pPixels{}; //Owned unless isExternal, pSurface only wraps it
+			bool isExternal{ false };
+			std::vector<TileState> tiles{};
+		};
+		std::vector<ColorTarget> m_ColorTargets{};
+		ColorTarget* m_pColorTarget{};
+		int m_HeadlessTarget{};
+		FramePresenter* m_pPresenter{}; //Null when headless
+
+		//Depth with a frame tag in the top byte so stale values always fail to occlude, no clear needed
+		bool m_TaggedDepth{ false }; //F11
+		uint32_t* m_pTaggedDepthPixels{};
+		uint32_t m_DepthGeneration{};
+
 		bool m_RenderBoundingBox{ false }; //F3
 		bool m_RenderDepth{ false }; //F4
 		bool m_RotateMeshes{ true }; //F5
 		bool m_RenderNormalMap{ true }; //F6
 		Rendermodes m_RenderMode{ Rendermodes::Combined }; //F7
+		RenderPath m_RenderPath{ RenderPath::W4_Part1 };
+		ShadingRate m_ShadingRate{ ShadingRate::Rate1x1 }; //F8
+		bool m_FoveatedShading{ false }; //F9
+		bool m_UseSIMDShading{ true }; //F10
+		Vector2 m_ShadingFocus{};
+
+		RasterStatistics m_Statistics{};
+		HeatmapMode m_HeatmapMode{ HeatmapMode::Off }; //F2
+		std::vector<uint16_t> m_HeatmapCounts{}; //Per pixel, m_Width stride like the color targets
+
+		//MSAA, depth per sample but shaded once per pixel per triangle.
+		//A pixel covered by a single triangle keeps one color, edge pixels move their samples to a block in m_MsaaSamples.
+		static constexpr uint32_t NoSampleBlock{ UINT32_MAX };
+		int m_SampleCount{ 1 }; //F12
+		bool m_MultisampledFrame{ false };
+		uint32_t* m_pMsaaColors{};
+		uint32_t* m_pMsaaBlocks{}; //Offset into m_MsaaSamples or NoSampleBlock
+		float* m_pSampleDepth{};
+		std::vector<uint32_t> m_MsaaSamples{};
+		alignas(32) float m_SampleOffsetX[8]{};
+		alignas(32) float m_SampleOffsetY[8]{};
 		
 		Camera m_Camera{};
 
 		int m_Width{};
 		int m_Height{};
 
-		Texture* m_pTexture{};
-		Texture* m_pDiffuseTexture{};
-		Texture* m_pGlossTexture{};
-		Texture* m_pNormalTexture{};
-		Texture* m_pSpecularTexture{};
+		//Part of the buffers W4 renders to, smaller than m_Width x m_Height under dynamic resolution.
+		//Rows keep the m_Width stride so nothing is reallocated, the presenter stretches it over the window.
+		int m_RenderWidth{};
+		int m_RenderHeight{};
+		//The whole frame the render rect is part of, projection maps to this and then shifts by m_FrameX, m_FrameY
+		int m_FrameWidth{};
+		int m_FrameHeight{};
+		int m_FrameX{};
+		int m_FrameY{};
+		DynamicResolution* m_pDynamicResolution{};
+
+		std::shared_ptr<const Scene> m_pScene{};
+		const Texture* m_pTexture{};
+		const Texture* m_pDiffuseTexture{};
+		const Texture* m_pGlossTexture{};
+		const Texture* m_pNormalTexture{};
+		const Texture* m_pSpecularTexture{};
 
 		std::vector<Mesh> m_Meshes{};
+		bool m_HasLoadedAssets{ false };
+		float m_LodPixelError{ 1.f };
+
+		FragmentBatch m_FragmentBatch{};
+
+		//Allocates the color targets unless pExternalPixels provides colorTargetCount buffers
+		void CreateBuffers(int colorTargetCount, uint32_t* const* pExternalPixels = nullptr);
+		void Initialize();
+		//Swaps the scene's placeholders for the assets that finished loading since the last frame
+		void UpdateAssets();
 
 		//Function that transforms the vertices from the mesh from World space to Screen space
 		void VertexTransformationFunction(const std::vector<Vertex>& vertices_in, std::vector<Vertex>& vertices_out) const; //W1 Version
 		void VertexTransformationFunction(const std::vector<Mesh>& mesh_in, std::vector<Mesh>& mesh_out) const; //W2 Version
 		void VertexTransformationFunction(std::vector<Mesh>& meshes) const;
+		//Decodes the level of mesh.pSharedData picked for this frame
+		void TransformPackedVertices(Mesh& mesh, const Matrix& worldViewProjectionMatrix) const;
+		//From the mesh's bounding sphere as seen by the camera
+		int SelectLod(const Mesh& mesh) const;
 
 		ColorRGB PixelShading(const Vertex_Out& v) const;
+		void PixelShading(const FragmentBatch& batch, ColorBatch& colors) const; //8 fragments at once
+		void AddToFragmentBatch(const Vertex_Out& v, int cellX, int cellY, int rate, uint16_t coverage);
+		void FlushFragmentBatch();
+		void WriteShadingCell(uint32_t pixel, int cellX, int cellY, int rate, uint16_t coverage);
+
+		void RasterizeMultisampled(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, int minX, int minY, int maxX, int maxY);
+		void WriteSamples(uint32_t pixel, int px, int py, uint16_t coverage);
+		void ResolveSamples();
+		uint32_t AverageSamples(uint32_t block) const;
+
+		uint32_t PackColor(ColorRGB color) const;
+		void BeginFrame();
+		void ClearTiles(int minX, int minY, int maxX, int maxY);
+		void ClearUntouchedTiles();
+		bool DepthTest(size_t pixelIndex, float depth);
+		void PackColors(const ColorBatch& colors, uint32_t* pPixels) const; //8 colors at once
+		void CountHeat(HeatmapMode mode, int px, int py)
+		{
+			if (m_HeatmapMode == mode)
+				++m_HeatmapCounts[size_t(px) + size_t(py) * m_Width];
+		}
+		//Overwrites the render rect with the heatmap colors
+		void DrawHeatmap();
+		Vertex_Out InterpolateVertex(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, float w0, float w1, float w2) const;
+		int GetShadingRate(ShadingRate meshRate, int px, int py) const;
 		
 
 	};
@@ -0,0 +1,81 @@
+#pragma once
+
+// AVX2 helpers for the wide (8 lane) paths, only available when compiled with /arch:AVX2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#include <cfloat>
+
+namespace dae
+{
+	namespace SIMD
+	{
+		constexpr int Width{ 8 };
+
+		/* --- VECTOR HELPERS --- */
+		inline __m256 Dot(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+		{
+			return _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(az, bz)));
+		}
+
+		inline void Cross(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz, __m256& outX, __m256& outY, __m256& outZ)
+		{
+			outX = _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by));
+			outY = _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz));
+			outZ = _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx));
+		}
+
+		inline void Normalize(__m256& x, __m256& y, __m256& z)
+		{
+			const __m256 magnitude{ _mm256_sqrt_ps(Dot(x, y, z, x, y, z)) };
+			x = _mm256_div_ps(x, magnitude);
+			y = _mm256_div_ps(y, magnitude);
+			z = _mm256_div_ps(z, magnitude);
+		}
+
+		/* --- TRANSCENDENTALS --- */
+		// Polynomial approximations, relative error around 1e-5 which is plenty for shading
+		inline __m256 Log2(__m256 x)
+		{
+			const __m256i bits{ _mm256_castps_si256(x) };
+			const __m256 exponent{ _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127))) };
+			const __m256 mantissa{ _mm256_castsi256_ps(_mm256_or_si256(
+				_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+				_mm256_set1_epi32(0x3F800000))) };
+
+			__m256 p{ _mm256_set1_ps(-3.4436006e-2f) };
+			p = _mm256_fmadd_ps(p, mantissa, _mm256_set1_ps(3.1821337e-1f));
+			p = _mm256_fmadd_ps(p, mantissa, _mm256_set1_ps(-1.2315303f));
+			p = _mm256_fmadd_ps(p, mantissa, _mm256_set1_ps(2.5988452f));
+			p = _mm256_fmadd_ps(p, mantissa, _mm256_set1_ps(-3.3241990f));
+			p = _mm256_fmadd_ps(p, mantissa, _mm256_set1_ps(3.1157899f));
+
+			return _mm256_fmadd_ps(p, _mm256_sub_ps(mantissa, _mm256_set1_ps(1.f)), exponent);
+		}
+
+		inline __m256 Exp2(__m256 x)
+		{
+			x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.99999f)), _mm256_set1_ps(129.f));
+
+			const __m256i integerPart{ _mm256_cvtps_epi32(_mm256_sub_ps(x, _mm256_set1_ps(.5f))) };
+			const __m256 fractionalPart{ _mm256_sub_ps(x, _mm256_cvtepi32_ps(integerPart)) };
+			const __m256 integerExp{ _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(integerPart, _mm256_set1_epi32(127)), 23)) };
+
+			__m256 p{ _mm256_set1_ps(1.8775767e-3f) };
+			p = _mm256_fmadd_ps(p, fractionalPart, _mm256_set1_ps(8.9893397e-3f));
+			p = _mm256_fmadd_ps(p, fractionalPart, _mm256_set1_ps(5.5826318e-2f));
+			p = _mm256_fmadd_ps(p, fractionalPart, _mm256_set1_ps(2.4015361e-1f));
+			p = _mm256_fmadd_ps(p, fractionalPart, _mm256_set1_ps(6.9315308e-1f));
+			p = _mm256_fmadd_ps(p, fractionalPart, _mm256_set1_ps(9.9999994e-1f));
+
+			return _mm256_mul_ps(integerExp, p);
+		}
+
+		// base must be >= 0, pow(0, 0) returns 1 like powf
+		inline __m256 Pow(__m256 base, __m256 exponent)
+		{
+			base = _mm256_max_ps(base, _mm256_set1_ps(FLT_MIN));
+			return Exp2(_mm256_mul_ps(exponent, Log2(base)));
+		}
+	}
+}
+#endif
@@ -0,0 +1,161 @@
+//Project includes
+#include "Scene.h"
+#include "AssetLoader.h"
+#include "MeshCache.h"
+#include "Texture.h"
+
+using namespace dae;
+
+namespace
+{
+	template<typename T>
+	bool IsReady(const std::shared_future<T>& future)
+	{
+		return future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+	}
+
+	//width x height in the xy plane around the origin, split into columns x rows quads facing -z.
+	//The rasterizer only fills one winding and drops triangles that leave the frustum, so keep it in view.
+	std::shared_ptr<const MeshData> CreateGrid(const std::string& name, int columns, int rows, float width, float height)
+	{
+		std::vector<Vertex> vertices{};
+		vertices.reserve(size_t(columns + 1) * (rows + 1));
+		for (int row{}; row <= rows; ++row)
+		{
+			for (int column{}; column <= columns; ++column)
+			{
+				const float u{ column / static_cast<float>(columns) };
+				const float v{ row / static_cast<float>(rows) };
+				Vertex vertex{};
+				vertex.position = { (u - .5f) * width, (.5f - v) * height, 0.f };
+				vertex.uv = { u, v };
+				vertex.normal = { 0.f, 0.f, -1.f };
+				vertex.tangent = { 1.f, 0.f, 0.f };
+				vertices.push_back(vertex);
+			}
+		}
+
+		std::vector<uint32_t> indices{};
+		indices.reserve(size_t(columns) * rows * 6);
+		for (int row{}; row < rows; ++row)
+		{
+			for (int column{}; column < columns; ++column)
+			{
+				const uint32_t topLeft{ static_cast<uint32_t>(row * (columns + 1) + column) };
+				const uint32_t bottomLeft{ topLeft + columns + 1 };
+				indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft, bottomLeft, topLeft + 1, bottomLeft + 1 });
+			}
+		}
+		return MeshCache::BuildMesh(name, std::move(vertices), std::move(indices));
+	}
+}
+
+Scene::Scene(SceneContent content) :
+	m_pLoader{ new AssetLoader{} }
+{
+	m_pGreyTexture = Texture::CreateSolid(colors::Gray);
+	m_pBlackTexture = Texture::CreateSolid(colors::Black);
+	m_pFlatNormalTexture = Texture::CreateSolid(ColorRGB{ .5f, .5f, 1.f });
+
+	//m_Texture = m_pLoader->LoadTexture("Resources/uv_grid_2.png");
+	m_Texture = m_pLoader->LoadTexture("Resources/tuktuk.png");
+
+	m_DiffuseTexture = m_pLoader->LoadTexture("Resources/vehicle_diffuse.png");
+	m_GlossTexture = m_pLoader->LoadTexture("Resources/vehicle_gloss.png");
+	m_NormalTexture = m_pLoader->LoadTexture("Resources/vehicle_normal.png");
+	m_SpecularTexture = m_pLoader->LoadTexture("Resources/vehicle_specular.png");
+
+	switch (content)
+	{
+	case SceneContent::Vehicle:
+	{
+		Mesh vehicle{};
+		vehicle.primitiveTopology = PrimitiveTopology::TriangleList;
+		vehicle.worldMatrix = Matrix::CreateTranslation(Vector3{ 0, 0, 50 });
+		m_Meshes.push_back(vehicle);
+		m_MeshData.push_back(m_pLoader->LoadMesh("Resources/vehicle.obj"));
+		break;
+	}
+	case SceneContent::TukTuk:
+	{
+		Mesh tuktuk{};
+		tuktuk.primitiveTopology = PrimitiveTopology::TriangleList;
+		tuktuk.worldMatrix = Matrix::CreateTranslation(Vector3{ 0, -5, 20 });
+		m_Meshes.push_back(tuktuk);
+		m_MeshData.push_back(m_pLoader->LoadMesh("Resources/tuktuk.obj"));
+		break;
+	}
+	case SceneContent::TriangleField:
+	{
+		//130K triangles of about 2 pixels each at 640x480
+		Mesh field{};
+		field.worldMatrix = Matrix::CreateTranslation(Vector3{ 0, 0, 20 });
+		m_Meshes.push_back(field);
+		m_MeshData.push_back(m_pLoader->Enqueue([]() { return CreateGrid("Triangle field", 256, 256, 20.f, 15.f); }));
+		break;
+	}
+	case SceneContent::Overdraw:
+	{
+		//One quad scaled with its distance, so every layer covers the same pixels
+		const auto quad{ m_pLoader->Enqueue([]() { return CreateGrid("Overdraw quad", 1, 1, .9f, .675f); }) };
+		constexpr int layerCount{ 16 };
+		for (int layer{}; layer < layerCount; ++layer)
+		{
+			const float distance{ 40.f - layer * 2.f };
+			Mesh layerMesh{};
+			layerMesh.worldMatrix = Matrix::CreateScale(distance, distance, 1.f) * Matrix::CreateTranslation(Vector3{ 0, 0, distance });
+			m_Meshes.push_back(layerMesh);
+			m_MeshData.push_back(quad);
+		}
+		break;
+	}
+	}
+}
+
+Scene::~Scene()
+{
+	//Finishes the loads still running, the futures own what they loaded
+	delete m_pLoader;
+	delete m_pGreyTexture;
+	delete m_pBlackTexture;
+	delete m_pFlatNormalTexture;
+}
+
+bool Scene::IsLoaded() const
+{
+	for (const TextureFuture* pTexture : { &m_Texture, &m_DiffuseTexture, &m_GlossTexture, &m_NormalTexture, &m_SpecularTexture })
+	{
+		if (!IsReady(*pTexture))
+			return false;
+	}
+
+	for (const auto& meshData : m_MeshData)
+	{
+		if (!IsReady(meshData))
+			return false;
+	}
+	return true;
+}
+
+void Scene::WaitUntilLoaded() const
+{
+	for (const TextureFuture* pTexture : { &m_Texture, &m_DiffuseTexture, &m_GlossTexture, &m_NormalTexture, &m_SpecularTexture })
+		pTexture->wait();
+
+	for (const auto& meshData : m_MeshData)
+		meshData.wait();
+}
+
+std::shared_ptr<const MeshData> Scene::GetMeshData(size_t meshIndex) const
+{
+	const auto& meshData{ m_MeshData[meshIndex] };
+	return IsReady(meshData) ? meshData.get() : nullptr;
+}
+
+const Texture* Scene::GetLoaded(const TextureFuture& texture, const Texture* pPlaceholder)
+{
+	//A texture that failed to load keeps its placeholder
+	if (!IsReady(texture) || !texture.get())
+		return pPlaceholder;
+	return texture.get().get();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//Standard includes
+#include <future>
+#include <memory>
+#include <vector>
+
+//Project includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	class Texture;
+	class AssetLoader;
+
+	//Meshes a Scene loads, the textures are the same for all of them
+	enum class SceneContent
+	{
+		Vehicle, //vehicle.obj
+		TukTuk, //tuktuk.obj
+		TriangleField, //Generated, a view filling grid of triangles a few pixels in size
+		Overdraw //Generated, view filling quads stacked back to front so every layer passes the depth test
+	};
+
+	//Textures and meshes the Renderer draws, shared read-only by every Renderer that draws them.
+	//All of them load at the same time on an AssetLoader, the getters hand out placeholders until they are done.
+	class Scene final
+	{
+	public:
+		explicit Scene(SceneContent content = SceneContent::Vehicle);
+		~Scene();
+
+		Scene(const Scene&) = delete;
+		Scene(Scene&&) noexcept = delete;
+		Scene& operator=(const Scene&) = delete;
+		Scene& operator=(Scene&&) noexcept = delete;
+
+		//True once every asset finished loading (or failed to)
+		bool IsLoaded() const;
+		void WaitUntilLoaded() const;
+
+		const Texture* GetTexture() const { return GetLoaded(m_Texture, m_pGreyTexture); }
+		const Texture* GetDiffuseTexture() const { return GetLoaded(m_DiffuseTexture, m_pGreyTexture); }
+		const Texture* GetGlossTexture() const { return GetLoaded(m_GlossTexture, m_pBlackTexture); }
+		const Texture* GetNormalTexture() const { return GetLoaded(m_NormalTexture, m_pFlatNormalTexture); }
+		const Texture* GetSpecularTexture() const { return GetLoaded(m_SpecularTexture, m_pBlackTexture); }
+
+		//Meshes in their start pose without geometry, GetMeshData provides Mesh::pSharedData for each of them
+		const std::vector<Mesh>& GetMeshes() const { return m_Meshes; }
+		//nullptr while the mesh is loading
+		std::shared_ptr<const MeshData> GetMeshData(size_t meshIndex) const;
+
+	private:
+		using TextureFuture = std::shared_future<std::shared_ptr<const Texture>>;
+
+		AssetLoader* m_pLoader{};
+
+		TextureFuture m_Texture{};
+		TextureFuture m_DiffuseTexture{};
+		TextureFuture m_GlossTexture{};
+		TextureFuture m_NormalTexture{};
+		TextureFuture m_SpecularTexture{};
+
+		//Stand-ins with no effect on the shading they replace
+		Texture* m_pGreyTexture{};
+		Texture* m_pBlackTexture{};
+		Texture* m_pFlatNormalTexture{};
+
+		std::vector<Mesh> m_Meshes{};
+		std::vector<std::shared_future<std::shared_ptr<const MeshData>>> m_MeshData{};
+
+		static const Texture* GetLoaded(const TextureFuture& texture, const Texture* pPlaceholder);
+	};
+}
@@ -0,0 +1,350 @@
+//Standard includes
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <thread>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Project includes
+#include "SharedFrameRing.h"
+
+using namespace dae;
+using namespace dae::SharedFrames;
+
+namespace
+{
+	//Same as dae::AlignUp, kept here so this file still builds on its own
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	uint64_t GetTimeNs()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	//Heartbeats can be written just after now was read
+	bool IsStale(const ReaderCursor& reader, uint64_t now)
+	{
+		const uint64_t heartbeat{ reader.heartbeatNs.load(std::memory_order_acquire) };
+		return heartbeat < now && now - heartbeat > ReaderTimeoutNs;
+	}
+
+	//Spin a little first, frames normally free up within microseconds
+	void WaitBriefly(int attempt)
+	{
+		if (attempt < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+	}
+}
+
+/* --- SHARED MAPPING --- */
+SharedMapping::~SharedMapping()
+{
+	if (!m_pData)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_pData);
+	CloseHandle(m_Handle);
+#else
+	munmap(m_pData, m_Size);
+	if (m_IsOwner)
+		shm_unlink(m_Name.c_str());
+#endif
+}
+
+bool SharedMapping::Create(const std::string& name, size_t size)
+{
+	m_IsOwner = true;
+	m_Size = size;
+#if defined(_WIN32)
+	m_Name = "Local\\" + name;
+	m_Handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(uint64_t(size) >> 32), static_cast<DWORD>(size), m_Name.c_str());
+	if (!m_Handle)
+		return false;
+
+	m_pData = static_cast<uint8_t*>(MapViewOfFile(m_Handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (!m_pData)
+	{
+		CloseHandle(m_Handle);
+		m_Handle = nullptr;
+		return false;
+	}
+#else
+	m_Name = "/" + name;
+	//A producer that crashed leaves its ring behind, start from scratch
+	shm_unlink(m_Name.c_str());
+	const int file{ shm_open(m_Name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
+	if (file < 0)
+		return false;
+
+	if (ftruncate(file, static_cast<off_t>(size)) != 0)
+	{
+		close(file);
+		shm_unlink(m_Name.c_str());
+		return false;
+	}
+
+	void* pData{ mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) };
+	close(file);
+	if (pData == MAP_FAILED)
+	{
+		shm_unlink(m_Name.c_str());
+		return false;
+	}
+	m_pData = static_cast<uint8_t*>(pData);
+#endif
+	return true;
+}
+
+bool SharedMapping::Open(const std::string& name)
+{
+	m_IsOwner = false;
+#if defined(_WIN32)
+	m_Name = "Local\\" + name;
+	m_Handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_Name.c_str());
+	if (!m_Handle)
+		return false;
+
+	m_pData = static_cast<uint8_t*>(MapViewOfFile(m_Handle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+	if (!m_pData)
+	{
+		CloseHandle(m_Handle);
+		m_Handle = nullptr;
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION info{};
+	VirtualQuery(m_pData, &info, sizeof(info));
+	m_Size = info.RegionSize;
+#else
+	m_Name = "/" + name;
+	const int file{ shm_open(m_Name.c_str(), O_RDWR, 0600) };
+	if (file < 0)
+		return false;
+
+	struct stat fileInfo{};
+	if (fstat(file, &fileInfo) != 0 || fileInfo.st_size <= 0)
+	{
+		close(file);
+		return false;
+	}
+	m_Size = static_cast<size_t>(fileInfo.st_size);
+
+	void* pData{ mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) };
+	close(file);
+	if (pData == MAP_FAILED)
+		return false;
+	m_pData = static_cast<uint8_t*>(pData);
+#endif
+	return true;
+}
+
+/* --- WRITER --- */
+SharedFrameWriter::SharedFrameWriter(const std::string& name, int width, int height, int slotCount, bool isBlocking) :
+	m_Width{ width },
+	m_Height{ height }
+{
+	slotCount = std::max(slotCount, 1);
+
+	//Slots start on a page so the pixels are aligned for the Renderer's streaming stores
+	const size_t slotStride{ AlignUp(size_t(width) * height * sizeof(uint32_t), PageSize) };
+	const size_t slotOffset{ AlignUp(sizeof(RingHeader) + sizeof(FrameHeader) * slotCount, PageSize) };
+	if (!m_Mapping.Create(name, slotOffset + slotStride * slotCount))
+		return;
+
+	m_pRing = new (m_Mapping.GetData()) RingHeader{};
+	m_pRing->version = Version;
+	m_pRing->slotCount = static_cast<uint32_t>(slotCount);
+	m_pRing->isBlocking = isBlocking ? 1 : 0;
+	m_pRing->slotOffset = slotOffset;
+	m_pRing->slotStride = slotStride;
+
+	m_pFrames = new (m_Mapping.GetData() + sizeof(RingHeader)) FrameHeader[slotCount]{};
+	for (int i{}; i < slotCount; ++i)
+		m_pFrames[i].sequence.store(UINT64_MAX, std::memory_order_relaxed);
+
+	//Readers refuse the ring until the magic shows up
+	std::atomic_thread_fence(std::memory_order_release);
+	m_pRing->magic = Magic;
+}
+
+uint32_t* SharedFrameWriter::GetSlotPixels(int slot) const
+{
+	return reinterpret_cast<uint32_t*>(m_Mapping.GetData() + m_pRing->slotOffset + m_pRing->slotStride * slot);
+}
+
+int SharedFrameWriter::AcquireSlot()
+{
+	//Only this thread writes writeIndex
+	const uint64_t writeIndex{ m_pRing->writeIndex.load(std::memory_order_relaxed) };
+	const int slot{ static_cast<int>(writeIndex % m_pRing->slotCount) };
+
+	if (m_pRing->isBlocking)
+	{
+		for (ReaderCursor& reader : m_pRing->readers)
+		{
+			for (int attempt{}; reader.state.load(std::memory_order_acquire) == 2
+				&& writeIndex - reader.readIndex.load(std::memory_order_acquire) >= m_pRing->slotCount; ++attempt)
+			{
+				//A consumer that crashed never releases its cursor, without this the producer would wait forever
+				if (IsStale(reader, GetTimeNs()))
+				{
+					uint32_t activeState{ 2 };
+					reader.state.compare_exchange_strong(activeState, 0, std::memory_order_acq_rel);
+					break;
+				}
+				WaitBriefly(attempt);
+			}
+		}
+	}
+	else
+	{
+		//Readers still holding this slot notice it changed under them when they release it
+		m_pFrames[slot].sequence.store(UINT64_MAX, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	return slot;
+}
+
+void SharedFrameWriter::Publish()
+{
+	const uint64_t writeIndex{ m_pRing->writeIndex.load(std::memory_order_relaxed) };
+	FrameHeader& frame{ m_pFrames[writeIndex % m_pRing->slotCount] };
+
+	frame.timestampNs = GetTimeNs();
+	frame.width = static_cast<uint32_t>(m_Width);
+	frame.height = static_cast<uint32_t>(m_Height);
+	frame.pitch = static_cast<uint32_t>(m_Width * sizeof(uint32_t));
+	frame.format = PixelFormat::XRGB8888;
+	frame.size = uint64_t(frame.pitch) * m_Height;
+	frame.sequence.store(writeIndex, std::memory_order_release);
+
+	m_pRing->writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+/* --- READER --- */
+SharedFrameReader::SharedFrameReader(const std::string& name)
+{
+	if (!m_Mapping.Open(name) || m_Mapping.GetSize() < sizeof(RingHeader))
+		return;
+
+	RingHeader* pRing{ reinterpret_cast<RingHeader*>(m_Mapping.GetData()) };
+	if (pRing->magic != Magic || pRing->version != Version)
+		return;
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	m_pRing = pRing;
+	m_pFrames = reinterpret_cast<const FrameHeader*>(m_Mapping.GetData() + sizeof(RingHeader));
+
+	//Free cursors first, then the ones dead readers left behind
+	const uint64_t now{ GetTimeNs() };
+	for (int pass{}; pass < 2 && m_ReaderIndex < 0; ++pass)
+	{
+		for (int i{}; i < MaxReaders; ++i)
+		{
+			ReaderCursor& reader{ m_pRing->readers[i] };
+			uint32_t expectedState{ pass == 0 ? 0u : 2u };
+			if (pass == 1 && !IsStale(reader, now))
+				continue;
+			if (!reader.state.compare_exchange_strong(expectedState, 1, std::memory_order_acq_rel))
+				continue;
+
+			//Start at the next frame, the producer ignores the cursor until it is active
+			m_Owner = reader.owner.fetch_add(1, std::memory_order_acq_rel) + 1;
+			reader.heartbeatNs.store(now, std::memory_order_relaxed);
+			reader.readIndex.store(m_pRing->writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+			reader.state.store(2, std::memory_order_release);
+			m_ReaderIndex = i;
+			break;
+		}
+	}
+}
+
+SharedFrameReader::~SharedFrameReader()
+{
+	//Lets a blocking producer continue without us, unless the cursor already went to another reader
+	if (m_ReaderIndex >= 0 && m_pRing->readers[m_ReaderIndex].owner.load(std::memory_order_acquire) == m_Owner)
+	{
+		uint32_t activeState{ 2 };
+		m_pRing->readers[m_ReaderIndex].state.compare_exchange_strong(activeState, 0, std::memory_order_acq_rel);
+	}
+}
+
+bool SharedFrameReader::KeepAlive()
+{
+	if (m_ReaderIndex < 0)
+		return false;
+
+	ReaderCursor& cursor{ m_pRing->readers[m_ReaderIndex] };
+	cursor.heartbeatNs.store(GetTimeNs(), std::memory_order_release);
+	if (cursor.state.load(std::memory_order_acquire) == 2 && cursor.owner.load(std::memory_order_acquire) == m_Owner)
+		return true;
+
+	//Evicted after going silent for too long, the frames it skipped are gone
+	m_ReaderIndex = -1;
+	return false;
+}
+
+bool SharedFrameReader::TryAcquire(Frame& frame)
+{
+	if (!KeepAlive())
+		return false;
+
+	ReaderCursor& cursor{ m_pRing->readers[m_ReaderIndex] };
+	uint64_t readIndex{ cursor.readIndex.load(std::memory_order_relaxed) };
+
+	while (true)
+	{
+		const uint64_t writeIndex{ m_pRing->writeIndex.load(std::memory_order_acquire) };
+		if (readIndex == writeIndex)
+			return false;
+
+		//Lapped by a non-blocking producer, the oldest frame still in the ring is the next one
+		if (writeIndex - readIndex > m_pRing->slotCount)
+			readIndex = writeIndex - m_pRing->slotCount;
+
+		const uint64_t slot{ readIndex % m_pRing->slotCount };
+		const FrameHeader& header{ m_pFrames[slot] };
+		if (header.sequence.load(std::memory_order_acquire) != readIndex)
+		{
+			//Being overwritten right now, try the next one
+			cursor.readIndex.store(++readIndex, std::memory_order_release);
+			continue;
+		}
+
+		cursor.readIndex.store(readIndex, std::memory_order_release);
+		m_AcquiredIndex = readIndex;
+		frame.pHeader = &header;
+		frame.pPixels = reinterpret_cast<const uint32_t*>(m_Mapping.GetData() + m_pRing->slotOffset + m_pRing->slotStride * slot);
+		return true;
+	}
+}
+
+bool SharedFrameReader::Release()
+{
+	if (!KeepAlive())
+		return false;
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const bool isIntact{ m_pFrames[m_AcquiredIndex % m_pRing->slotCount].sequence.load(std::memory_order_relaxed) == m_AcquiredIndex };
+
+	m_pRing->readers[m_ReaderIndex].readIndex.store(m_AcquiredIndex + 1, std::memory_order_release);
+	return isIntact;
+}
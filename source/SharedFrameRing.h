@@ -0,0 +1,160 @@
+#pragma once
+
+//Standard includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//Frame ring in named shared memory: the Renderer draws straight into a slot, consumers in other processes read it in place.
+//This header and SharedFrameRing.cpp have no other project or SDL dependencies, consumers build just these two files.
+namespace dae
+{
+	namespace SharedFrames
+	{
+		constexpr uint32_t Magic{ 0x46454144 }; //"DAEF"
+		constexpr uint32_t Version{ 2 };
+		constexpr int MaxReaders{ 4 };
+		constexpr size_t PageSize{ 4096 };
+		//A reader that has not called TryAcquire or Release for this long is taken for dead (crashed or killed).
+		//A blocking producer stops waiting for it and a new reader may take its cursor.
+		constexpr uint64_t ReaderTimeoutNs{ 2'000'000'000 };
+
+		enum class PixelFormat : uint32_t
+		{
+			XRGB8888 = 0 //0x00RRGGBB per pixel
+		};
+
+		//Written by the producer before the frame is published
+		struct alignas(64) FrameHeader
+		{
+			std::atomic<uint64_t> sequence{}; //Frame number, also tells a reader whether the slot was overwritten
+			uint64_t timestampNs{}; //steady_clock
+			uint64_t size{}; //Bytes of pixel data
+			uint32_t width{};
+			uint32_t height{};
+			uint32_t pitch{};
+			PixelFormat format{};
+		};
+
+		struct alignas(64) ReaderCursor
+		{
+			std::atomic<uint32_t> state{}; //0 free, 1 attaching, 2 active
+			std::atomic<uint64_t> readIndex{};
+			std::atomic<uint64_t> heartbeatNs{}; //steady_clock, refreshed by every TryAcquire and Release
+			std::atomic<uint64_t> owner{}; //Changes whenever the cursor is taken, an evicted reader notices it lost the cursor
+		};
+
+		//Start of the mapping, followed by slotCount FrameHeaders and then the page aligned slots
+		struct alignas(64) RingHeader
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint32_t slotCount{};
+			uint32_t isBlocking{}; //Producer waits for readers instead of overwriting unread frames
+			uint64_t slotOffset{};
+			uint64_t slotStride{};
+
+			alignas(64) std::atomic<uint64_t> writeIndex{}; //Frames published so far
+			ReaderCursor readers[MaxReaders]{};
+		};
+
+		static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+			"The ring indices are shared between processes and have to be lock free");
+	}
+
+	//OS handle of a named mapping, shared by the writer and the reader
+	class SharedMapping final
+	{
+	public:
+		SharedMapping() = default;
+		~SharedMapping();
+
+		SharedMapping(const SharedMapping&) = delete;
+		SharedMapping(SharedMapping&&) noexcept = delete;
+		SharedMapping& operator=(const SharedMapping&) = delete;
+		SharedMapping& operator=(SharedMapping&&) noexcept = delete;
+
+		bool Create(const std::string& name, size_t size);
+		bool Open(const std::string& name);
+
+		uint8_t* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		std::string m_Name{};
+		uint8_t* m_pData{};
+		size_t m_Size{};
+		bool m_IsOwner{};
+		void* m_Handle{}; //Windows file mapping
+	};
+
+	//Producer side, single producer
+	class SharedFrameWriter final
+	{
+	public:
+		SharedFrameWriter(const std::string& name, int width, int height, int slotCount = 4, bool isBlocking = true);
+		~SharedFrameWriter() = default;
+
+		SharedFrameWriter(const SharedFrameWriter&) = delete;
+		SharedFrameWriter(SharedFrameWriter&&) noexcept = delete;
+		SharedFrameWriter& operator=(const SharedFrameWriter&) = delete;
+		SharedFrameWriter& operator=(SharedFrameWriter&&) noexcept = delete;
+
+		bool IsOpen() const { return m_pRing != nullptr; }
+		int GetSlotCount() const { return static_cast<int>(m_pRing->slotCount); }
+		uint32_t* GetSlotPixels(int slot) const;
+
+		//Slot the next frame goes into. When blocking this waits until every attached reader released it,
+		//readers silent for longer than SharedFrames::ReaderTimeoutNs are evicted instead.
+		int AcquireSlot();
+		//Makes the frame in the acquired slot visible to readers
+		void Publish();
+
+	private:
+		SharedMapping m_Mapping{};
+		SharedFrames::RingHeader* m_pRing{};
+		SharedFrames::FrameHeader* m_pFrames{};
+		int m_Width{};
+		int m_Height{};
+	};
+
+	//Consumer side, up to SharedFrames::MaxReaders readers per ring, each sees every frame published after it attached
+	class SharedFrameReader final
+	{
+	public:
+		struct Frame
+		{
+			const SharedFrames::FrameHeader* pHeader{};
+			const uint32_t* pPixels{};
+		};
+
+		explicit SharedFrameReader(const std::string& name);
+		~SharedFrameReader();
+
+		SharedFrameReader(const SharedFrameReader&) = delete;
+		SharedFrameReader(SharedFrameReader&&) noexcept = delete;
+		SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+		SharedFrameReader& operator=(SharedFrameReader&&) noexcept = delete;
+
+		//False when the ring does not exist, all reader cursors are taken or the producer evicted this reader
+		bool IsOpen() const { return m_ReaderIndex >= 0; }
+
+		//Points frame at the oldest unread frame without copying it, false when there is none yet.
+		//A non-blocking producer may have lapped the reader, the missed frames are skipped.
+		bool TryAcquire(Frame& frame);
+		//Done with the acquired frame. False if a non-blocking producer overwrote it in the meantime.
+		bool Release();
+
+	private:
+		SharedMapping m_Mapping{};
+		SharedFrames::RingHeader* m_pRing{};
+		const SharedFrames::FrameHeader* m_pFrames{};
+		int m_ReaderIndex{ -1 };
+		uint64_t m_Owner{};
+		uint64_t m_AcquiredIndex{};
+
+		//Refreshes the heartbeat, false (and closed) once the cursor was evicted
+		bool KeepAlive();
+	};
+}
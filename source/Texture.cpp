@@ -1,41 +1,388 @@
 #include "Texture.h"
 #include "Vector2.h"
+#include "SIMDHelpers.h"
+#include "MappedFile.h"
+#include "Utils.h"
 #include <SDL_image.h>
+#include <algorithm>
+#include <climits>
 
-namespace dae
+namespace
 {
-	Texture::Texture(SDL_Surface* pSurface) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+	//Bump when the layout below or the mip/BC1 generation changes
+	constexpr uint32_t ContainerVersion{ 1 };
+	constexpr char ContainerMagic[4]{ 'D', 'A', 'E', 'T' };
+	constexpr uint32_t MaxLevelCount{ 32 };
+
+	struct ContainerHeader
+	{
+		char magic[4]{};
+		uint32_t version{};
+		uint64_t sourceHash{};
+		uint32_t levelCount{};
+		uint32_t padding{};
+	};
+
+	//Follows the header, one per mip level
+	struct LevelEntry
+	{
+		uint32_t width{};
+		uint32_t height{};
+		uint64_t texelOffset{};
+		uint64_t blockOffset{};
+	};
+
+	size_t GetBlockCount(uint32_t width, uint32_t height)
+	{
+		return size_t((width + 3) / 4) * ((height + 3) / 4);
+	}
+
+	uint32_t GetChannel(uint32_t texel, int channel)
+	{
+		return (texel >> (channel * 8)) & 0xFF;
+	}
+
+	//Box filter, the last row/column is repeated for odd sizes
+	std::vector<uint32_t> Downsample(const std::vector<uint32_t>& texels, uint32_t width, uint32_t height)
 	{
+		const uint32_t halfWidth{ std::max(width / 2, 1u) };
+		const uint32_t halfHeight{ std::max(height / 2, 1u) };
+		std::vector<uint32_t> result(size_t(halfWidth) * halfHeight);
+
+		for (uint32_t y{}; y < halfHeight; ++y)
+		{
+			const uint32_t y0{ std::min(y * 2, height - 1) };
+			const uint32_t y1{ std::min(y * 2 + 1, height - 1) };
+			for (uint32_t x{}; x < halfWidth; ++x)
+			{
+				const uint32_t x0{ std::min(x * 2, width - 1) };
+				const uint32_t x1{ std::min(x * 2 + 1, width - 1) };
+				const uint32_t quad[4]{ texels[y0 * width + x0], texels[y0 * width + x1], texels[y1 * width + x0], texels[y1 * width + x1] };
+
+				uint32_t texel{};
+				for (int channel{}; channel < 4; ++channel)
+				{
+					const uint32_t sum{ GetChannel(quad[0], channel) + GetChannel(quad[1], channel) + GetChannel(quad[2], channel) + GetChannel(quad[3], channel) };
+					texel |= ((sum + 2) / 4) << (channel * 8);
+				}
+				result[y * halfWidth + x] = texel;
+			}
+		}
+		return result;
+	}
+
+	uint16_t ToRGB565(uint32_t r, uint32_t g, uint32_t b)
+	{
+		return static_cast<uint16_t>((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
 	}
 
-	Texture::~Texture()
+	//The four colors a BC1 block picks from, per channel
+	void DecodePalette(uint64_t block, int palette[4][3])
 	{
-		if (m_pSurface)
+		const uint32_t color0{ uint32_t(block & 0xFFFF) };
+		const uint32_t color1{ uint32_t((block >> 16) & 0xFFFF) };
+		for (int i{}; i < 2; ++i)
+		{
+			const uint32_t color{ i == 0 ? color0 : color1 };
+			const uint32_t r{ (color >> 11) & 31 }, g{ (color >> 5) & 63 }, b{ color & 31 };
+			palette[i][0] = int(r << 3 | r >> 2);
+			palette[i][1] = int(g << 2 | g >> 4);
+			palette[i][2] = int(b << 3 | b >> 2);
+		}
+
+		for (int channel{}; channel < 3; ++channel)
 		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+			//Four colors when color0 > color1, otherwise three and black
+			if (color0 > color1)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+			}
+			else
+			{
+				palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+				palette[3][channel] = 0;
+			}
 		}
 	}
 
+	//Endpoints are the corners of the block's color bounding box
+	uint64_t EncodeBlock(const std::vector<uint32_t>& texels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY)
+	{
+		uint32_t block[16]{};
+		uint32_t minimum[3]{ 255, 255, 255 };
+		uint32_t maximum[3]{};
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			const uint32_t x{ std::min(blockX * 4 + i % 4, width - 1) };
+			const uint32_t y{ std::min(blockY * 4 + i / 4, height - 1) };
+			block[i] = texels[y * width + x];
+			for (int channel{}; channel < 3; ++channel)
+			{
+				minimum[channel] = std::min(minimum[channel], GetChannel(block[i], channel));
+				maximum[channel] = std::max(maximum[channel], GetChannel(block[i], channel));
+			}
+		}
+
+		uint16_t color0{ ToRGB565(maximum[0], maximum[1], maximum[2]) };
+		uint16_t color1{ ToRGB565(minimum[0], minimum[1], minimum[2]) };
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		uint64_t encoded{ uint64_t(color0) | uint64_t(color1) << 16 };
+		if (color0 == color1)
+			return encoded;
+
+		int palette[4][3]{};
+		DecodePalette(encoded, palette);
+		for (uint32_t i{}; i < 16; ++i)
+		{
+			int bestIndex{};
+			int bestDistance{ INT_MAX };
+			for (int index{}; index < 4; ++index)
+			{
+				int distance{};
+				for (int channel{}; channel < 3; ++channel)
+				{
+					const int difference{ int(GetChannel(block[i], channel)) - palette[index][channel] };
+					distance += difference * difference;
+				}
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+			encoded |= uint64_t(bestIndex) << (32 + i * 2);
+		}
+		return encoded;
+	}
+
+	//Copies the surface's pixels as RGBA8, an empty vector when SDL can't convert them
+	std::vector<uint32_t> ConvertSurface(SDL_Surface* pSurface)
+	{
+		SDL_Surface* pConverted{ SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0) };
+		if (!pConverted)
+			return {};
+
+		std::vector<uint32_t> texels(size_t(pConverted->w) * pConverted->h);
+		for (int y{}; y < pConverted->h; ++y)
+			memcpy(texels.data() + size_t(y) * pConverted->w, static_cast<const uint8_t*>(pConverted->pixels) + size_t(y) * pConverted->pitch, pConverted->w * sizeof(uint32_t));
+		SDL_FreeSurface(pConverted);
+		return texels;
+	}
+
+	//Header, level table, then per level the texels and the BC1 blocks, exactly as the file is written
+	std::vector<uint8_t> BuildContainer(std::vector<uint32_t>&& texels, uint32_t width, uint32_t height, uint64_t sourceHash)
+	{
+		std::vector<std::vector<uint32_t>> levels{};
+		std::vector<LevelEntry> entries{};
+		size_t offset{ dae::AlignUp(sizeof(ContainerHeader) + sizeof(LevelEntry) * MaxLevelCount, dae::CacheSectionAlignment) };
+		while (true)
+		{
+			LevelEntry& entry{ entries.emplace_back() };
+			entry.width = width;
+			entry.height = height;
+			entry.texelOffset = offset;
+			entry.blockOffset = dae::AlignUp(offset + texels.size() * sizeof(uint32_t), dae::CacheSectionAlignment);
+			offset = dae::AlignUp(entry.blockOffset + GetBlockCount(width, height) * sizeof(uint64_t), dae::CacheSectionAlignment);
+
+			const bool isLast{ width == 1 && height == 1 };
+			levels.push_back(std::move(texels));
+			if (isLast)
+				break;
+
+			texels = Downsample(levels.back(), width, height);
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+		}
+
+		std::vector<uint8_t> container(offset);
+		ContainerHeader header{};
+		memcpy(header.magic, ContainerMagic, sizeof(ContainerMagic));
+		header.version = ContainerVersion;
+		header.sourceHash = sourceHash;
+		header.levelCount = uint32_t(entries.size());
+		memcpy(container.data(), &header, sizeof(header));
+		memcpy(container.data() + sizeof(header), entries.data(), entries.size() * sizeof(LevelEntry));
+
+		for (size_t level{}; level < levels.size(); ++level)
+		{
+			const LevelEntry& entry{ entries[level] };
+			memcpy(container.data() + entry.texelOffset, levels[level].data(), levels[level].size() * sizeof(uint32_t));
+
+			uint64_t* pBlocks{ reinterpret_cast<uint64_t*>(container.data() + entry.blockOffset) };
+			const uint32_t blocksPerRow{ (entry.width + 3) / 4 };
+			for (uint32_t blockY{}; blockY < (entry.height + 3) / 4; ++blockY)
+				for (uint32_t blockX{}; blockX < blocksPerRow; ++blockX)
+					pBlocks[blockY * blocksPerRow + blockX] = EncodeBlock(levels[level], entry.width, entry.height, blockX, blockY);
+		}
+		return container;
+	}
+
+	bool IsValidContainer(const uint8_t* pData, size_t size, uint64_t sourceHash)
+	{
+		if (size < sizeof(ContainerHeader) + sizeof(LevelEntry) * MaxLevelCount)
+			return false;
+
+		ContainerHeader header{};
+		memcpy(&header, pData, sizeof(header));
+		if (memcmp(header.magic, ContainerMagic, sizeof(ContainerMagic)) != 0
+			|| header.version != ContainerVersion
+			|| header.sourceHash != sourceHash
+			|| header.levelCount == 0 || header.levelCount > MaxLevelCount)
+			return false;
+
+		//Every level has to lie inside the file before anything points at it
+		for (uint32_t level{}; level < header.levelCount; ++level)
+		{
+			LevelEntry entry{};
+			memcpy(&entry, pData + sizeof(header) + level * sizeof(LevelEntry), sizeof(entry));
+			if (entry.width == 0 || entry.height == 0
+				|| !dae::IsSectionInFile(entry.texelOffset, uint64_t(entry.width) * entry.height, sizeof(uint32_t), size)
+				|| !dae::IsSectionInFile(entry.blockOffset, GetBlockCount(entry.width, entry.height), sizeof(uint64_t), size))
+				return false;
+		}
+		return true;
+	}
+}
+
+namespace dae
+{
+	Texture::Texture(std::shared_ptr<const MappedFile> pMappedFile, std::vector<uint8_t>&& container) :
+		m_pMappedFile{ std::move(pMappedFile) },
+		m_Container{ std::move(container) }
+	{
+		const uint8_t* pData{ m_pMappedFile ? m_pMappedFile->GetData() : m_Container.data() };
+
+		ContainerHeader header{};
+		memcpy(&header, pData, sizeof(header));
+		for (uint32_t level{}; level < header.levelCount; ++level)
+		{
+			LevelEntry entry{};
+			memcpy(&entry, pData + sizeof(header) + level * sizeof(LevelEntry), sizeof(entry));
+			m_Levels.push_back(Level{ int(entry.width), int(entry.height),
+				reinterpret_cast<const uint32_t*>(pData + entry.texelOffset), reinterpret_cast<const uint64_t*>(pData + entry.blockOffset) });
+		}
+
+		m_pTexels = m_Levels.front().pTexels;
+		m_Width = m_Levels.front().width;
+		m_Height = m_Levels.front().height;
+	}
+
 	Texture* Texture::LoadFromFile(const std::string& path)
 	{
-		//Load SDL_Surface using IMG_LOAD
-		//Create & Return a new Texture Object (using SDL_Surface)
-		return new Texture{ IMG_Load(path.c_str()) };
+		uint64_t sourceHash{};
+		{
+			const MappedFile source{ path };
+			if (!source.IsOpen())
+				return nullptr;
+			sourceHash = Utils::HashBytes(source.GetData(), source.GetSize());
+		}
+
+		//Mapped read-only, so every process drawing this texture shares the same pages
+		const std::string cachePath{ path + ".texcache" };
+		auto pCache{ std::make_shared<const MappedFile>(cachePath) };
+		if (pCache->IsOpen() && IsValidContainer(pCache->GetData(), pCache->GetSize(), sourceHash))
+			return new Texture{ std::move(pCache), {} };
+		//Released before the rewrite below, Windows cannot replace a mapped file
+		pCache.reset();
+
+		//Load SDL_Surface using IMG_LOAD, only when there is no cache yet
+		SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
+		if (!pSurface)
+			return nullptr;
+		const uint32_t width{ uint32_t(pSurface->w) };
+		const uint32_t height{ uint32_t(pSurface->h) };
+		std::vector<uint32_t> texels{ ConvertSurface(pSurface) };
+		SDL_FreeSurface(pSurface);
+		if (texels.empty())
+			return nullptr;
+		std::vector<uint8_t> container{ BuildContainer(std::move(texels), width, height, sourceHash) };
+
+		if (WriteFileAtomically(cachePath, container))
+		{
+			pCache = std::make_shared<const MappedFile>(cachePath);
+			if (pCache->IsOpen() && IsValidContainer(pCache->GetData(), pCache->GetSize(), sourceHash))
+				return new Texture{ std::move(pCache), {} };
+		}
+		return new Texture{ nullptr, std::move(container) };
+	}
+
+	Texture* Texture::CreateSolid(const ColorRGB& color)
+	{
+		const auto toChannel = [](float value) { return uint32_t(std::clamp(value, 0.f, 1.f) * 255.f + .5f); };
+		const uint32_t texel{ toChannel(color.r) | toChannel(color.g) << 8 | toChannel(color.b) << 16 | 0xFF000000 };
+		return new Texture{ nullptr, BuildContainer({ texel }, 1, 1, 0) };
 	}
 
 	ColorRGB Texture::Sample(const Vector2& uv) const
 	{
-		//Sample the correct texel for the given uv
-		
-		Uint32 u = uv.x * m_pSurface->w;
-		Uint32 v = uv.y * m_pSurface->h;
-		
-		Uint8 r, g, b;
-		SDL_GetRGB(m_pSurfacePixels[Uint32(v * m_pSurface->w + u)], m_pSurface->format, &r, &g, &b);
-		ColorRGB color{ r, g, b };
+		//Sample the correct texel for the given uv, clamped like Sample8 so uv's of exactly 1 stay inside the texture
+		const int u{ std::clamp(int(uv.x * m_Width), 0, m_Width - 1) };
+		const int v{ std::clamp(int(uv.y * m_Height), 0, m_Height - 1) };
+
+		const uint32_t texel{ m_pTexels[v * m_Width + u] };
+		ColorRGB color{ float(GetChannel(texel, 0)), float(GetChannel(texel, 1)), float(GetChannel(texel, 2)) };
 		return  color / 255.0f;
 	}
-}
\ No newline at end of file
+
+	void Texture::Sample8(const float* u, const float* v, float* r, float* g, float* b) const
+	{
+#if defined(__AVX2__)
+		const __m256i width{ _mm256_set1_epi32(m_Width) };
+
+		//Same truncation as Sample, clamped so uv's of exactly 1 stay inside the texture
+		__m256i texelU{ _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(u), _mm256_set1_ps(float(m_Width)))) };
+		__m256i texelV{ _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(v), _mm256_set1_ps(float(m_Height)))) };
+		texelU = _mm256_min_epi32(_mm256_max_epi32(texelU, _mm256_setzero_si256()), _mm256_set1_epi32(m_Width - 1));
+		texelV = _mm256_min_epi32(_mm256_max_epi32(texelV, _mm256_setzero_si256()), _mm256_set1_epi32(m_Height - 1));
+
+		const __m256i index{ _mm256_add_epi32(_mm256_mullo_epi32(texelV, width), texelU) };
+		const __m256i texels{ _mm256_i32gather_epi32(reinterpret_cast<const int*>(m_pTexels), index, 4) };
+
+		const __m256i channelMask{ _mm256_set1_epi32(0xFF) };
+		const __m256 toUnit{ _mm256_set1_ps(1.f / 255.f) };
+		const auto extractChannel = [&](int shift)
+		{
+			const __m256i channel{ _mm256_and_si256(_mm256_srli_epi32(texels, shift), channelMask) };
+			return _mm256_mul_ps(_mm256_cvtepi32_ps(channel), toUnit);
+		};
+
+		_mm256_storeu_ps(r, extractChannel(0));
+		_mm256_storeu_ps(g, extractChannel(8));
+		_mm256_storeu_ps(b, extractChannel(16));
+#else
+		for (int i{}; i < 8; ++i)
+		{
+			const ColorRGB color{ Sample(Vector2{ u[i], v[i] }) };
+			r[i] = color.r;
+			g[i] = color.g;
+			b[i] = color.b;
+		}
+#endif
+	}
+
+	ColorRGB Texture::SampleLevel(const Vector2& uv, int level) const
+	{
+		const Level& mip{ m_Levels[std::clamp(level, 0, GetLevelCount() - 1)] };
+		const int u{ std::clamp(int(uv.x * mip.width), 0, mip.width - 1) };
+		const int v{ std::clamp(int(uv.y * mip.height), 0, mip.height - 1) };
+
+		const uint32_t texel{ mip.pTexels[v * mip.width + u] };
+		return ColorRGB{ float(GetChannel(texel, 0)), float(GetChannel(texel, 1)), float(GetChannel(texel, 2)) } / 255.f;
+	}
+
+	ColorRGB Texture::SampleCompressed(const Vector2& uv, int level) const
+	{
+		const Level& mip{ m_Levels[std::clamp(level, 0, GetLevelCount() - 1)] };
+		const int u{ std::clamp(int(uv.x * mip.width), 0, mip.width - 1) };
+		const int v{ std::clamp(int(uv.y * mip.height), 0, mip.height - 1) };
+
+		const uint64_t block{ mip.pBlocks[(v / 4) * ((mip.width + 3) / 4) + u / 4] };
+		int palette[4][3]{};
+		DecodePalette(block, palette);
+
+		const int index{ int((block >> (32 + ((v % 4) * 4 + u % 4) * 2)) & 3) };
+		return ColorRGB{ float(palette[index][0]), float(palette[index][1]), float(palette[index][2]) } / 255.f;
+	}}
@@ -1,24 +1,63 @@
 #pragma once
-#include <SDL_surface.h>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 #include "ColorRGB.h"
 
 namespace dae
 {
 	struct Vector2;
+	class MappedFile;
 
 	class Texture
 	{
 	public:
-		~Texture();
+		~Texture() = default;
 
+		Texture(const Texture&) = delete;
+		Texture(Texture&&) noexcept = delete;
+		Texture& operator=(const Texture&) = delete;
+		Texture& operator=(Texture&&) noexcept = delete;
+
+		//Reads the texels from <path>.texcache, which is decoded from the image (with mip levels and a BC1 copy)
+		//the first time or whenever the image changed. nullptr when neither can be read.
 		static Texture* LoadFromFile(const std::string& path);
+		//Single texel, for standing in while the real texture loads
+		static Texture* CreateSolid(const ColorRGB& color);
 		ColorRGB Sample(const Vector2& uv) const;
+		//Samples 8 uv's at once, results are written as separate channels
+		void Sample8(const float* u, const float* v, float* r, float* g, float* b) const;
+
+		//Point sample of a mip level, 0 is the full image
+		ColorRGB SampleLevel(const Vector2& uv, int level) const;
+		//Same, decoded from the BC1 blocks
+		ColorRGB SampleCompressed(const Vector2& uv, int level) const;
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+		int GetLevelCount() const { return static_cast<int>(m_Levels.size()); }
 
 	private:
-		Texture(SDL_Surface* pSurface);
+		struct Level
+		{
+			int width{};
+			int height{};
+			//RGBA, 8 bits per channel, red in the lowest byte
+			const uint32_t* pTexels{};
+			//BC1 blocks of 4x4 texels, row by row
+			const uint64_t* pBlocks{};
+		};
+
+		Texture(std::shared_ptr<const MappedFile> pMappedFile, std::vector<uint8_t>&& container);
+
+		//The container lives in the mapping, or in m_Container when the cache could not be written
+		std::shared_ptr<const MappedFile> m_pMappedFile{};
+		std::vector<uint8_t> m_Container{};
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		std::vector<Level> m_Levels{};
+		const uint32_t* m_pTexels{ nullptr };
+		int m_Width{};
+		int m_Height{};
 	};
-}
\ No newline at end of file
+}
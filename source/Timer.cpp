@@ -1,11 +1,13 @@
 #include "Timer.h"
 #include "SDL.h"
+#include "MathHelpers.h"
+#include <algorithm>
 using namespace dae;
 
 Timer::Timer()
 {
 	const uint64_t countsPerSecond = SDL_GetPerformanceFrequency();
-	m_SecondsPerCount = 1.0f / static_cast<float>(countsPerSecond);
+	m_SecondsPerCount = 1.0 / static_cast<double>(countsPerSecond);
 }
 
 void Timer::Reset()
@@ -13,11 +15,15 @@ void Timer::Reset()
 	const uint64_t currentTime = SDL_GetPerformanceCounter();
 
 	m_BaseTime = currentTime;
+	m_PausedTime = 0;
 	m_PreviousTime = currentTime;
 	m_StopTime = 0;
 	m_FPSTimer = 0.0f;
 	m_FPSCount = 0;
 	m_IsStopped = false;
+
+	m_FrameCount = 0;
+	m_OverBudgetCount = 0;
 }
 
 void Timer::Start()
@@ -40,15 +46,18 @@ void Timer::Update()
 	{
 		m_FPS = 0;
 		m_ElapsedTime = 0.0f;
-		m_TotalTime = (float)(((m_StopTime - m_PausedTime) - m_BaseTime) * m_BaseTime);
+		m_TotalTime = ((m_StopTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount;
 		return;
 	}
 
 	const uint64_t currentTime = SDL_GetPerformanceCounter();
 	m_CurrentTime = currentTime;
 
-	m_ElapsedTime = (float)((m_CurrentTime - m_PreviousTime) * m_SecondsPerCount);
+	const double frameTime = (m_CurrentTime - m_PreviousTime) * m_SecondsPerCount;
 	m_PreviousTime = m_CurrentTime;
+	RecordFrameTime(frameTime);
+
+	m_ElapsedTime = (float)frameTime;
 
 	if (m_ElapsedTime < 0.0f)
 		m_ElapsedTime = 0.0f;
@@ -58,7 +67,7 @@ void Timer::Update()
 		m_ElapsedTime = m_ElapsedUpperBound;
 	}
 
-	m_TotalTime = (float)(((m_CurrentTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount);
+	m_TotalTime = ((m_CurrentTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount;
 
 	//FPS LOGIC
 	m_FPSTimer += m_ElapsedTime;
@@ -82,3 +91,45 @@ void Timer::Stop()
 		m_IsStopped = true;
 	}
 }
+
+FrameTimeSnapshot Timer::GetSnapshot() const
+{
+	FrameTimeSnapshot snapshot{};
+	snapshot.budget = m_FrameBudget;
+	snapshot.totalOverBudgetCount = m_OverBudgetCount;
+	snapshot.totalFrameCount = m_FrameCount;
+	snapshot.totalTime = m_TotalTime;
+
+	const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(m_FrameCount, FrameHistorySize));
+	if (count == 0)
+		return snapshot;
+
+	//Order does not matter for any of these, the filled part of the ring is always its start
+	std::array<double, FrameHistorySize> sorted = m_FrameTimes;
+	std::sort(sorted.begin(), sorted.begin() + count);
+
+	double total = 0.0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		total += sorted[i];
+		if (m_FrameBudget > 0.0 && sorted[i] > m_FrameBudget)
+			++snapshot.overBudgetCount;
+	}
+
+	snapshot.frameCount = count;
+	snapshot.min = sorted[0];
+	snapshot.max = sorted[count - 1];
+	snapshot.mean = total / count;
+	snapshot.p50 = Percentile(sorted.data(), count, 50.0);
+	snapshot.p95 = Percentile(sorted.data(), count, 95.0);
+	snapshot.p99 = Percentile(sorted.data(), count, 99.0);
+	return snapshot;
+}
+
+void Timer::RecordFrameTime(double frameTime)
+{
+	m_FrameTimes[m_FrameCount % FrameHistorySize] = frameTime;
+	++m_FrameCount;
+	if (m_FrameBudget > 0.0 && frameTime > m_FrameBudget)
+		++m_OverBudgetCount;
+}
\ No newline at end of file
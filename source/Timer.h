@@ -1,13 +1,35 @@
 #pragma once
 
 //Standard includes
+#include <array>
 #include <cstdint>
 
 namespace dae
 {
+	//Frame times of the last Timer::FrameHistorySize frames, in seconds and before the elapsed upper bound
+	struct FrameTimeSnapshot
+	{
+		uint32_t frameCount = 0; //In the window, less than FrameHistorySize until the history fills up
+		double min = 0.0;
+		double max = 0.0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+
+		double budget = 0.0;
+		uint32_t overBudgetCount = 0; //In the window
+		uint64_t totalOverBudgetCount = 0; //Since the last Reset
+		uint64_t totalFrameCount = 0;
+
+		double totalTime = 0.0;
+	};
+
 	class Timer
 	{
 	public:
+		static constexpr uint32_t FrameHistorySize = 1024;
+
 		Timer();
 		virtual ~Timer() = default;
 
@@ -24,9 +46,15 @@ namespace dae
 		uint32_t GetFPS() const { return m_FPS; };
 		float GetdFPS() const { return m_dFPS; };
 		float GetElapsed() const { return m_ElapsedTime; };
-		float GetTotal() const { return m_TotalTime; };
+		double GetTotal() const { return m_TotalTime; };
 		bool IsRunning() const { return !m_IsStopped; };
 
+		//Frames that take longer than budget seconds are counted, 0 counts none
+		void SetFrameBudget(double budget) { m_FrameBudget = budget; };
+		//Sorts a copy of the history, cheap enough to poll once a second but not every frame.
+		//Not thread safe, call it from the thread that calls Update.
+		FrameTimeSnapshot GetSnapshot() const;
+
 	private:
 		uint64_t m_BaseTime = 0;
 		uint64_t m_PausedTime = 0;
@@ -38,13 +66,21 @@ namespace dae
 		float m_dFPS = 0.0f;
 		uint32_t m_FPSCount = 0;
 
-		float m_TotalTime = 0.0f;
+		double m_TotalTime = 0.0;
 		float m_ElapsedTime = 0.0f;
-		float m_SecondsPerCount = 0.0f;
+		double m_SecondsPerCount = 0.0;
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
 
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
+
+		//Ring of the last frame times, m_FrameCount % FrameHistorySize is the next one to overwrite
+		std::array<double, FrameHistorySize> m_FrameTimes{};
+		uint64_t m_FrameCount = 0;
+		double m_FrameBudget = 0.0;
+		uint64_t m_OverBudgetCount = 0;
+
+		void RecordFrameTime(double frameTime);
 	};
 }
\ No newline at end of file
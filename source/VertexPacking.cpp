@@ -0,0 +1,93 @@
+//Standard includes
+#include <algorithm>
+
+//Project includes
+#include "VertexPacking.h"
+
+using namespace dae;
+
+namespace
+{
+	constexpr float QuantizedMax{ 65535.f };
+
+	uint16_t Quantize(float value, float min, float max)
+	{
+		if (max <= min)
+			return 0;
+		return static_cast<uint16_t>(std::lround(std::clamp((value - min) / (max - min), 0.f, 1.f) * QuantizedMax));
+	}
+
+	int16_t ToSnorm(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+	}
+}
+
+PackedVertex VertexPacking::Pack(const Vertex& vertex, const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	PackedVertex packed{};
+	for (int axis{}; axis < 3; ++axis)
+		packed.position[axis] = Quantize(vertex.position[axis], boundsMin[axis], boundsMax[axis]);
+	packed.uv[0] = ToHalf(vertex.uv.x);
+	packed.uv[1] = ToHalf(vertex.uv.y);
+	EncodeOctahedral(vertex.normal, packed.normal);
+	EncodeOctahedral(vertex.tangent, packed.tangent);
+	return packed;
+}
+
+uint16_t VertexPacking::ToHalf(float value)
+{
+	uint32_t bits{};
+	memcpy(&bits, &value, sizeof(bits));
+	const uint16_t sign{ static_cast<uint16_t>((bits >> 16) & 0x8000) };
+	const int exponent{ static_cast<int>((bits >> 23) & 0xFF) - 127 + 15 };
+	uint32_t mantissa{ bits & 0x7FFFFF };
+
+	if ((bits & 0x7FFFFFFF) > 0x7F800000)
+		return sign | 0x7E00; //NaN
+	if (exponent >= 31)
+		return sign | 0x7C00;
+
+	//Too small for a normal half, the implicit leading bit becomes part of the mantissa
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		const int shift{ 14 - exponent };
+		const uint32_t half{ (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1) };
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	//Rounding may carry into the exponent, which is still the right value
+	const uint32_t half{ (uint32_t(exponent) << 10 | (mantissa >> 13)) + ((mantissa >> 12) & 1) };
+	return static_cast<uint16_t>(sign | std::min(half, 0x7C00u));
+}
+
+void VertexPacking::EncodeOctahedral(const Vector3& direction, int16_t encoded[2])
+{
+	//Zero (or NaN) vectors decode as +z
+	const float length{ std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) };
+	if (!(length > 0.f))
+	{
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+
+	float x{ direction.x / length };
+	float y{ direction.y / length };
+	if (direction.z < 0.f)
+	{
+		const float foldedX{ (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f) };
+		y = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = foldedX;
+	}
+	encoded[0] = ToSnorm(x);
+	encoded[1] = ToSnorm(y);
+}
+
+Matrix VertexPacking::GetDequantizeMatrix(const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	const Vector3 extent{ boundsMax - boundsMin };
+	return Matrix::CreateScale(extent.x / QuantizedMax, extent.y / QuantizedMax, extent.z / QuantizedMax) * Matrix::CreateTranslation(boundsMin);
+}
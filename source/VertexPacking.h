@@ -0,0 +1,64 @@
+#pragma once
+
+//Standard includes
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//Project includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Encoding of PackedVertex. The decoders are inline, the vertex transform runs them for every vertex of every frame.
+	namespace VertexPacking
+	{
+		//Positions are quantized across boundsMin..boundsMax, normals and tangents normalized first
+		PackedVertex Pack(const Vertex& vertex, const Vector3& boundsMin, const Vector3& boundsMax);
+
+		//Round to nearest, out of range values become infinity
+		uint16_t ToHalf(float value);
+
+		inline float FromHalf(uint16_t half)
+		{
+			const uint32_t sign{ uint32_t(half & 0x8000) << 16 };
+			const uint32_t exponent{ uint32_t(half >> 10) & 0x1F };
+			const uint32_t mantissa{ uint32_t(half) & 0x3FF };
+
+			uint32_t bits{};
+			if (exponent == 0)
+			{
+				const float value{ std::ldexp(static_cast<float>(mantissa), -24) };
+				return sign ? -value : value;
+			}
+			if (exponent == 31)
+				bits = sign | 0x7F800000 | (mantissa << 13);
+			else
+				bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+			float value{};
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		//Unit vector folded onto the octahedron |x| + |y| + |z| = 1 and its lower half over the upper one
+		void EncodeOctahedral(const Vector3& direction, int16_t encoded[2]);
+
+		inline Vector3 DecodeOctahedral(const int16_t encoded[2])
+		{
+			float x{ encoded[0] / 32767.f };
+			float y{ encoded[1] / 32767.f };
+			const float z{ 1.f - std::abs(x) - std::abs(y) };
+			if (z < 0.f)
+			{
+				const float foldedX{ (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f) };
+				y = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+				x = foldedX;
+			}
+			return Vector3{ x, y, z }.Normalized();
+		}
+
+		//Maps the quantized position (0..65535 per axis) back into object space, put in front of the world matrix
+		Matrix GetDequantizeMatrix(const Vector3& boundsMin, const Vector3& boundsMax);
+	}
+}
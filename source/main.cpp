@@ -5,11 +5,22 @@
 #undef main
 
 //Standard includes
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <thread>
 
 //Project includes
 #include "Timer.h"
 #include "Renderer.h"
+#include "BatchRenderer.h"
+#include "CaptureQueue.h"
+#include "FrameStream.h"
+#include "Profiler.h"
+#include "SharedFrameRing.h"
+#include "Utils.h"
 
 using namespace dae;
 
@@ -19,18 +30,338 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
+ImageFormat ParseImageFormat(const char* name)
+{
+	if (strcmp(name, "png") == 0)
+		return ImageFormat::PNG;
+	if (strcmp(name, "qoi") == 0)
+		return ImageFormat::QOI;
+	return ImageFormat::BMP;
+}
+
+StreamFormat ParseStreamFormat(const char* name)
+{
+	if (strcmp(name, "rgba") == 0)
+		return StreamFormat::RGBA;
+	if (strcmp(name, "bgra") == 0)
+		return StreamFormat::BGRA;
+	return StreamFormat::Y4M;
+}
+
+//Queues the current frame as captureDirectory/frame_00000.ext, ...
+void CaptureFrame(CaptureQueue& captureQueue, const Renderer& renderer, const std::string& captureDirectory, ImageFormat format, int frame)
+{
+	char fileName[32]{};
+	snprintf(fileName, sizeof(fileName), "/frame_%05d%s", frame, GetExtension(format));
+	captureQueue.Submit(renderer.GetPixels(), renderer.GetRenderWidth(), renderer.GetRenderHeight(), renderer.GetWidth(), captureDirectory + fileName, format,
+		[](const std::string& filePath, bool isSaved)
+		{
+			if (!isSaved)
+				std::cout << "Could not save " << filePath << std::endl;
+		});
+}
+
+//Rolling frame time percentiles, our targets are on p99 rather than the average
+void PrintFrameTimes(const FrameTimeSnapshot& snapshot)
+{
+	std::cout << "Frame time of the last " << snapshot.frameCount << " frames: min " << snapshot.min * 1000.0 << " ms, p50 " << snapshot.p50 * 1000.0
+		<< " ms, p95 " << snapshot.p95 * 1000.0 << " ms, p99 " << snapshot.p99 * 1000.0 << " ms, max " << snapshot.max * 1000.0 << " ms";
+	if (snapshot.budget > 0.0)
+		std::cout << ", " << snapshot.overBudgetCount << " over the " << snapshot.budget * 1000.0 << " ms budget (" << snapshot.totalOverBudgetCount << " in total)";
+	std::cout << std::endl;
+}
+
+//No window and no SDL video, renders frameCount frames offscreen and keeps the last one
+int RunHeadless(uint32_t width, uint32_t height, int frameCount, int sampleCount, float lodError, double frameBudget, const std::string& captureDirectory, ImageFormat captureFormat, FrameStream* pStream)
+{
+	//Encoding runs next to rendering, one worker per spare core so capture keeps up with the frame rate
+	const int captureWorkers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+	CaptureQueue captureQueue{ captureWorkers * 2, captureWorkers };
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(width, height);
+	pRenderer->SetSampleCount(sampleCount);
+	pRenderer->SetLodError(lodError);
+
+	pTimer->SetFrameBudget(frameBudget);
+	pTimer->Start();
+	float totalTime = 0.f;
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		pRenderer->Update(pTimer);
+		pRenderer->Render();
+		PROFILE_END_FRAME();
+		if (!captureDirectory.empty())
+			CaptureFrame(captureQueue, *pRenderer, captureDirectory, captureFormat, frame);
+		if (pStream && !pStream->Submit(pRenderer->GetPixels()))
+		{
+			std::cout << "Stream closed after " << frame << " frames" << std::endl;
+			frameCount = frame;
+			break;
+		}
+
+		pTimer->Update();
+		totalTime += pTimer->GetElapsed();
+	}
+	pTimer->Stop();
+	captureQueue.Flush();
+
+	std::cout << frameCount << " frames in " << totalTime << "s, FPS: " << frameCount / totalTime << std::endl;
+	PrintFrameTimes(pTimer->GetSnapshot());
+	if (pRenderer->SaveBufferToImage())
+		std::cout << "Last frame saved!" << std::endl;
+
+	delete pRenderer;
+	delete pTimer;
+	SDL_Quit();
+	return 0;
+}
+
+//No window, renders frameCount frames straight into the slots of a shared memory ring for other processes to read
+int RunSharedRing(uint32_t width, uint32_t height, int frameCount, int sampleCount, float lodError, double frameBudget, const std::string& ringName, int slotCount, bool isBlocking)
+{
+	SharedFrameWriter writer{ ringName, static_cast<int>(width), static_cast<int>(height), slotCount, isBlocking };
+	if (!writer.IsOpen())
+	{
+		std::cout << "Could not create shared memory ring " << ringName << std::endl;
+		return 1;
+	}
+
+	std::vector<uint32_t*> slotPixels{};
+	for (int slot = 0; slot < writer.GetSlotCount(); ++slot)
+		slotPixels.push_back(writer.GetSlotPixels(slot));
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(width, height, slotPixels);
+	pRenderer->SetSampleCount(sampleCount);
+	pRenderer->SetLodError(lodError);
+
+	pTimer->SetFrameBudget(frameBudget);
+	pTimer->Start();
+	float totalTime = 0.f;
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		pRenderer->SetColorTarget(writer.AcquireSlot());
+		pRenderer->Update(pTimer);
+		pRenderer->Render();
+		writer.Publish();
+		PROFILE_END_FRAME();
+
+		pTimer->Update();
+		totalTime += pTimer->GetElapsed();
+	}
+	pTimer->Stop();
+
+	std::cout << frameCount << " frames to " << ringName << " in " << totalTime << "s, FPS: " << frameCount / totalTime << std::endl;
+	PrintFrameTimes(pTimer->GetSnapshot());
+
+	delete pRenderer;
+	delete pTimer;
+	SDL_Quit();
+	return 0;
+}
+
+//No window, renders every pose in posesPath to outputDirectory spread over threadCount threads (0 = one per core)
+int RunBatch(uint32_t width, uint32_t height, float lodError, const std::string& posesPath, const std::string& outputDirectory, int threadCount, int bandHeight, ImageFormat format)
+{
+	BatchRenderer batchRenderer{ static_cast<int>(width), static_cast<int>(height), threadCount, bandHeight };
+	batchRenderer.SetLodError(lodError);
+	if (!batchRenderer.LoadPoses(posesPath))
+		return 1;
+
+	const int savedFrames = batchRenderer.Run(outputDirectory, format);
+
+	SDL_Quit();
+	return savedFrames == static_cast<int>(batchRenderer.GetPoseCount()) ? 0 : 1;
+}
+
+void PrintUsage()
+{
+	std::cout << "Rasterizer [options]\n"
+		<< "  --width <pixels> --height <pixels>  Resolution, at most 8192x8192 (default 640x480)\n"
+		<< "  --queue-depth <count>      Color targets shared with the present thread (default 2)\n"
+		<< "  --headless                 Render without a window\n"
+		<< "  --frames <count>           Frames rendered headless or into --shm (default 100)\n"
+		<< "  --batch <poses>            Render every camera pose in the file to --output\n"
+		<< "  --output <directory>       Batch images (default frames)\n"
+		<< "  --threads <count>          Batch threads, 0 is one per core (default 0)\n"
+		<< "  --capture <directory>      Save every frame\n"
+		<< "  --capture-format <format>  bmp, png or qoi (default bmp)\n"
+		<< "  --stream <target>          Raw frames to a file, a named pipe or - for stdout\n"
+		<< "  --stream-format <format>   y4m, rgba or bgra (default y4m)\n"
+		<< "  --fps <count>              Frame rate written in the stream header (default 60)\n"
+		<< "  --shm <name>               Render into a shared memory frame ring\n"
+		<< "  --shm-slots <count>        Frames in the ring (default 4)\n"
+		<< "  --shm-overwrite            Overwrite frames readers did not take yet instead of waiting\n"
+		<< "  --msaa <samples>           1, 4 or 8 (default 1)\n"
+		<< "  --band-height <rows>       Render batch images in bands of this many rows\n"
+		<< "  --target-fps <fps>         Scale the render resolution to hold this frame rate\n"
+		<< "  --min-scale <scale>        Lowest render scale for --target-fps (default 0.5)\n"
+		<< "  --lod-error <pixels>       Screen space error a mesh LOD may add (default 1)\n"
+		<< "  --frame-budget <ms>        Frames slower than this count as over budget\n"
+		<< "  --profile <frames>         Trace the first frames to --profile-output\n"
+		<< "  --profile-output <path>    Chrome trace (default Rasterizer_Profile.json)\n";
+}
+
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//8K is the largest frame the buffers and the 32 bit image headers are sized for
+	const uint32_t maxSize = 8192;
+	uint32_t width = 640;
+	uint32_t height = 480;
+
+	//Command line
+	int frameQueueDepth = 2;
+	bool isHeadless = false;
+	int headlessFrames = 100;
+	std::string batchPoses{};
+	std::string batchOutput = "frames";
+	int batchThreads = 0;
+	std::string captureDirectory{};
+	ImageFormat captureFormat = ImageFormat::BMP;
+	std::string streamTarget{};
+	StreamFormat streamFormat = StreamFormat::Y4M;
+	int streamFPS = 60;
+	std::string ringName{};
+	int ringSlots = 4;
+	bool isRingBlocking = true;
+	int sampleCount = 1;
+	int bandHeight = 0;
+	float targetFPS = 0.f;
+	float minRenderScale = .5f;
+	float lodError = 1.f;
+	float frameBudgetMs = 0.f;
+	int profileFrames = 0;
+	std::string profileOutput = "Rasterizer_Profile.json";
+	for (int i = 1; i < argc; ++i)
+	{
+		//Numbers are parsed whole, a malformed or out of range value prints the usage instead of throwing
+		bool isValid = true;
+		if (strcmp(args[i], "--queue-depth") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], frameQueueDepth);
+		else if (strcmp(args[i], "--headless") == 0)
+			isHeadless = true;
+		else if (strcmp(args[i], "--frames") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], headlessFrames);
+		else if (strcmp(args[i], "--batch") == 0 && i + 1 < argc)
+			batchPoses = args[++i];
+		else if (strcmp(args[i], "--output") == 0 && i + 1 < argc)
+			batchOutput = args[++i];
+		else if (strcmp(args[i], "--threads") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], batchThreads);
+		else if (strcmp(args[i], "--capture") == 0 && i + 1 < argc)
+			captureDirectory = args[++i];
+		else if (strcmp(args[i], "--capture-format") == 0 && i + 1 < argc)
+			captureFormat = ParseImageFormat(args[++i]);
+		else if (strcmp(args[i], "--stream") == 0 && i + 1 < argc)
+			streamTarget = args[++i];
+		else if (strcmp(args[i], "--stream-format") == 0 && i + 1 < argc)
+			streamFormat = ParseStreamFormat(args[++i]);
+		else if (strcmp(args[i], "--fps") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], streamFPS);
+		else if (strcmp(args[i], "--shm") == 0 && i + 1 < argc)
+			ringName = args[++i];
+		else if (strcmp(args[i], "--shm-slots") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], ringSlots);
+		else if (strcmp(args[i], "--shm-overwrite") == 0)
+			isRingBlocking = false;
+		else if (strcmp(args[i], "--msaa") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], sampleCount);
+		else if (strcmp(args[i], "--width") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], width);
+		else if (strcmp(args[i], "--height") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], height);
+		else if (strcmp(args[i], "--band-height") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], bandHeight);
+		else if (strcmp(args[i], "--target-fps") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], targetFPS);
+		else if (strcmp(args[i], "--min-scale") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], minRenderScale);
+		else if (strcmp(args[i], "--lod-error") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], lodError);
+		else if (strcmp(args[i], "--frame-budget") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], frameBudgetMs);
+		else if (strcmp(args[i], "--profile") == 0 && i + 1 < argc)
+			isValid = Utils::ParseNumber(args[++i], profileFrames);
+		else if (strcmp(args[i], "--profile-output") == 0 && i + 1 < argc)
+			profileOutput = args[++i];
+		else if (strcmp(args[i], "--help") == 0)
+		{
+			PrintUsage();
+			return 0;
+		}
+
+		if (!isValid)
+		{
+			std::cout << "Invalid value " << args[i] << " for " << args[i - 1] << std::endl;
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (width == 0 || height == 0 || width > maxSize || height > maxSize)
+	{
+		std::cout << "Resolution has to be between 1x1 and " << maxSize << "x" << maxSize << std::endl;
+		return 1;
+	}
+
+	if (!captureDirectory.empty())
+		std::filesystem::create_directories(captureDirectory);
+
+	//Frames slower than this are counted as over budget, by default the frame time of --target-fps or 60 FPS
+	const double frameBudget = frameBudgetMs > 0.f ? frameBudgetMs / 1000.0 : 1.0 / (targetFPS > 0.f ? targetFPS : 60.f);
+
+	//Traces the first profileFrames frames, P traces the next ones while the window is open
+#if DAE_PROFILING
+	PROFILE_THREAD_NAME("Main");
+	if (profileFrames > 0)
+		Profiler::RequestCapture(profileFrames, profileOutput);
+#else
+	if (profileFrames > 0)
+		std::cout << "Built with DAE_PROFILING=0, --profile is ignored. The Profile configuration records zones" << std::endl;
+#endif
+
+	if (!batchPoses.empty())
+	{
+		const int result = RunBatch(width, height, lodError, batchPoses, batchOutput, batchThreads, bandHeight, captureFormat);
+#if DAE_PROFILING
+		//A capture is written when its last frame ends, a batch with fewer poses never gets there
+		if (Profiler::IsCapturing())
+			std::cout << "Fewer than " << profileFrames << " poses were rendered, no profile was written" << std::endl;
+#endif
+		return result;
+	}
+
+	if (!ringName.empty())
+		return RunSharedRing(width, height, headlessFrames, sampleCount, lodError, frameBudget, ringName, ringSlots, isRingBlocking);
+
+	//Frames go to stdout, a file or a named pipe, e.g. --stream - | ffmpeg -i - out.mp4
+	FrameStream* pStream = nullptr;
+	if (!streamTarget.empty())
+	{
+		pStream = new FrameStream(streamTarget, width, height, streamFormat, streamFPS);
+		if (!pStream->IsOpen())
+		{
+			std::cerr << "Could not open stream " << streamTarget << std::endl;
+			delete pStream;
+			return 1;
+		}
+
+		//stdout only carries frames from here on, everything printed goes to stderr
+		if (pStream->IsStdout())
+			std::cout.rdbuf(std::cerr.rdbuf());
+	}
+
+	if (isHeadless)
+	{
+		const int result = RunHeadless(width, height, headlessFrames, sampleCount, lodError, frameBudget, captureDirectory, captureFormat, pStream);
+		delete pStream;
+		return result;
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
 
-	const uint32_t width = 640;
-	const uint32_t height = 480;
-
 	SDL_Window* pWindow = SDL_CreateWindow(
 		"Rasterizer - W6 DEMO",
 		SDL_WINDOWPOS_UNDEFINED,
@@ -42,11 +373,23 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderer = new Renderer(pWindow, frameQueueDepth);
+	pRenderer->SetSampleCount(sampleCount);
+	pRenderer->SetLodError(lodError);
+
+	//Holds the frame rate by lowering the render resolution, a stream needs every frame at the same size
+	if (targetFPS > 0.f && pStream)
+		std::cout << "Dynamic resolution is off while streaming" << std::endl;
+	else if (targetFPS > 0.f)
+		pRenderer->SetDynamicResolution(1.f / targetFPS, minRenderScale);
+	const int captureWorkers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+	auto pCaptureQueue = new CaptureQueue(captureWorkers * 2, captureWorkers);
 
 	//Start loop
+	pTimer->SetFrameBudget(frameBudget);
 	pTimer->Start();
 	float printTimer = 0.f;
+	int frame = 0;
 	bool isLooping = true;
 	bool takeScreenshot = false;
 	while (isLooping)
@@ -63,6 +406,11 @@ int main(int argc, char* args[])
 			case SDL_KEYUP:
 				if (e.key.keysym.scancode == SDL_SCANCODE_X)
 					takeScreenshot = true;
+#if DAE_PROFILING
+				//Without --profile a second's worth of frames at 60 FPS
+				if (e.key.keysym.scancode == SDL_SCANCODE_P)
+					Profiler::RequestCapture(profileFrames > 0 ? profileFrames : 60, profileOutput);
+#endif
 				pRenderer->InputLogic(e);
 				break;
 			}
@@ -73,6 +421,15 @@ int main(int argc, char* args[])
 
 		//--------- Render ---------
 		pRenderer->Render();
+		PROFILE_END_FRAME();
+		if (!captureDirectory.empty())
+			CaptureFrame(*pCaptureQueue, *pRenderer, captureDirectory, captureFormat, frame++);
+		if (pStream && !pStream->Submit(pRenderer->GetPixels()))
+		{
+			std::cout << "Stream closed, no longer streaming" << std::endl;
+			delete pStream;
+			pStream = nullptr;
+		}
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -80,22 +437,34 @@ int main(int argc, char* args[])
 		if (printTimer >= 1.f)
 		{
 			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			const FrameTimeSnapshot frameTimes = pTimer->GetSnapshot();
+			std::cout << "dFPS: " << pTimer->GetdFPS() << ", p99: " << frameTimes.p99 * 1000.0 << " ms, over budget: " << frameTimes.overBudgetCount;
+			if (targetFPS > 0.f)
+				std::cout << " at " << pRenderer->GetRenderWidth() << "x" << pRenderer->GetRenderHeight();
+			std::cout << std::endl;
 		}
 
-		//Save screenshot after full render
+		//Save screenshot after full render, written in the background
 		if (takeScreenshot)
 		{
-			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << std::endl;
-			else
-				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+			const std::string filePath = std::string{ "Rasterizer_ColorBuffer" } + GetExtension(captureFormat);
+			pCaptureQueue->Submit(pRenderer->GetPixels(), pRenderer->GetRenderWidth(), pRenderer->GetRenderHeight(), pRenderer->GetWidth(), filePath, captureFormat,
+				[](const std::string&, bool isSaved)
+				{
+					if (isSaved)
+						std::cout << "Screenshot saved!" << std::endl;
+					else
+						std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+				});
 			takeScreenshot = false;
 		}
 	}
 	pTimer->Stop();
+	PrintFrameTimes(pTimer->GetSnapshot());
 
 	//Shutdown "framework"
+	delete pStream;
+	delete pCaptureQueue;
 	delete pRenderer;
 	delete pTimer;
 